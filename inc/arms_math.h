@@ -94,3 +94,23 @@ struct Vec4
 
 float map_range_to(const float &value, const float &valueMin
     , const float &valueMax, const float &mapMin, const float &mapMax);
+
+/*!
+ *  Line-line intersection of two line segments
+ *
+ *  \param aBegin
+ *    The start of the first line
+ *  \param aEnd
+ *    The end of the first line
+ *  \param bBegin
+ *    The start of the second line
+ *  \param bEnd
+ *    The end of the second line
+ *  \param uA
+ *    Updated with the normalized point of intersection along the first line
+ *
+ *  \returns
+ *    If the lines intersect (parallel lines never do)
+ */
+bool line_line_intersection(const Vec2 &aBegin, const Vec2 &aEnd
+    , const Vec2 &bBegin, const Vec2 &bEnd, float &uA);
@@ -0,0 +1,137 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   audiobuffer.h
+ *
+ *  \brief
+ *    Interface of the aligned buffer audio samples are stored in
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/*!
+ *  \class AudioBuffer
+ *
+ *  \brief
+ *    An array of samples that starts on a cache line, so SIMD kernels can use
+ *    aligned loads and no block of samples straddles two lines more than it
+ *    has to. It is used the same as a CArray<float>.
+ *
+ *    resize zeroes the samples it adds while resize_uninitialized leaves them
+ *    as they are, for buffers that are about to be written over anyway.
+ *    Buffers of at least a huge page are aligned to one and, where the
+ *    system supports it, asked to be backed by huge pages so long renders
+ *    take fewer TLB misses.
+ */
+class AudioBuffer
+{
+  public:
+    // The alignment of every buffer, a cache line
+    static inline const size_t ALIGNMENT = 64;
+    // Buffers of this many bytes or more may be backed by huge pages
+    static inline const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    AudioBuffer();
+    /*!
+     *  Creates a buffer of silence
+     *
+     *  \param initalCount
+     *    The number of samples
+     */
+    AudioBuffer(const size_t &initalCount);
+    AudioBuffer(const AudioBuffer &other);
+    /*!
+     *  Takes the samples of another buffer, leaving it empty
+     *
+     *  \param other
+     *    The buffer being moved from
+     */
+    AudioBuffer(AudioBuffer &&other) noexcept;
+    ~AudioBuffer();
+
+    AudioBuffer &operator=(const AudioBuffer &other);
+    AudioBuffer &operator=(AudioBuffer &&other) noexcept;
+    /*!
+     *  Adds another buffer sample by sample, growing this one if it is
+     *  shorter
+     */
+    AudioBuffer &operator+=(const AudioBuffer &other);
+
+    /*!
+     *  \returns
+     *    If the system can back buffers with huge pages
+     */
+    static bool is_huge_page_supported();
+    /*!
+     *  Sets if large buffers are backed by huge pages, on by default. Only
+     *  buffers allocated afterwards are affected.
+     *
+     *  \param enabled
+     *    If huge pages are used
+     */
+    static void set_huge_pages(const bool &enabled);
+
+    const size_t &size() const;
+    /*!
+     *  \returns
+     *    The number of samples allocated
+     */
+    const size_t &capacity() const;
+    const float *front() const;
+    /*!
+     *  \returns
+     *    A pointer to the samples aligned to ALIGNMENT for unchecked access,
+     *    only the first size() are valid
+     */
+    float *data();
+    const float *data() const;
+
+    /*!
+     *  Gets a sample, growing the buffer the same as a CArray when given an
+     *  index past its end
+     */
+    float &operator[](const size_t &index);
+    /*!
+     *  Gets a sample, returning the last sample when given an index past the
+     *  end of the buffer
+     */
+    const float &at(const size_t &index) const;
+
+    /*!
+     *  Resizes the buffer, new samples are silent. The buffer is only
+     *  reallocated when growing past its capacity.
+     *
+     *  \param newSize
+     *    The new number of samples, 0 frees the buffer
+     */
+    void resize(const size_t &newSize);
+    /*!
+     *  Resizes the buffer without setting the new samples, which must be
+     *  written before they are read
+     *
+     *  \param newSize
+     *    The new number of samples, 0 frees the buffer
+     */
+    void resize_uninitialized(const size_t &newSize);
+    /*!
+     *  Makes sure the buffer can hold a number of samples without
+     *  reallocating, the size stays the same
+     *
+     *  \param newCapacity
+     *    The number of samples to allocate for
+     */
+    void reserve(const size_t &newCapacity);
+    void clear();
+
+  private:
+    static inline std::atomic<bool> hugePagesEnabled{true};
+
+    float *head = nullptr;
+    size_t count = 0;
+    size_t reserved = 0;
+    // The alignment head was allocated with, needed to free it
+    size_t alignment = ALIGNMENT;
+};
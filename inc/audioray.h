@@ -24,7 +24,7 @@ class AudioRay
 {
   public:
     // NOTE: Repurposing size as posB in line and normal pos and posA
-    AudioRay(Object *parent, const int &line, const CArray<Vec2> &amp
+    AudioRay(Object *parent, const int &line, const CoefficentArray &amp
         , const Vec2 &_posA, const Vec2 &_posB);
     ~AudioRay();
 
@@ -34,19 +34,19 @@ class AudioRay
     Vec2 get_posA() const;
     Vec2 get_posB() const;
 
-    const CArray<Vec2> &get_amp() const;
+    const CoefficentArray &get_amp() const;
     float get_distance() const;
 
     void set_parent_line(const int &line);
 
     void set_posA(const Vec2 &_posA);
     void set_posB(const Vec2 &_posB);
-    void set_amp(const CArray<Vec2> &amp);
+    void set_amp(const CoefficentArray &amp);
     void scale_amp(const float &scale);
-    void add_to_amp(const CArray<Vec2> &amp);
-    void scale_to_amp(const CArray<Vec2> &amp, const float &scale);
-    void scale_and_add_to_amp(const CArray<Vec2> &amp, const float &scale);
-    CArray<Vec2> add_amps(const CArray<Vec2> &amp);
+    void add_to_amp(const CoefficentArray &amp);
+    void scale_to_amp(const CoefficentArray &amp, const float &scale);
+    void scale_and_add_to_amp(const CoefficentArray &amp, const float &scale);
+    CoefficentArray add_amps(const CoefficentArray &amp);
     void inverse_amp();
 
     float get_amp_average();
@@ -60,6 +60,6 @@ class AudioRay
   
     Object *parent;
     int parentLine;
-    CArray<Vec2> coefficents;
+    CoefficentArray coefficents;
     std::array<sf::Vertex, 2> line;
 };
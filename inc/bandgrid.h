@@ -0,0 +1,199 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   bandgrid.h
+ *
+ *  \brief
+ *    Interface of the fixed frequency bands energy is tracked in
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "arms_math.h"
+#include "helper.h"
+#include "simd.h"
+
+class Object;
+
+/*!
+ *  \struct BandEnergy
+ *
+ *  \brief
+ *    A value for every band of a BandGrid (i.e. the energy of a ray or the
+ *    reflection factor of a material). It is always MAX_BANDS floats wide and
+ *    aligned so it can be updated with whole vector instructions, bands past
+ *    the grid's size are padding.
+ */
+struct alignas(32) BandEnergy
+{
+  static inline const size_t MAX_BANDS = 8;
+
+  BandEnergy()
+  {
+    fill(0.f);
+  }
+
+  explicit BandEnergy(const float &_value)
+  {
+    fill(_value);
+  }
+
+  void fill(const float &_value)
+  {
+    for(size_t i = 0; i < MAX_BANDS; ++i)
+    {
+      value[i] = _value;
+    }
+  }
+
+  BandEnergy &operator*=(const BandEnergy &other)
+  {
+#if ARMS_SSE2
+    _mm_store_ps(value, _mm_mul_ps(_mm_load_ps(value)
+          , _mm_load_ps(other.value)));
+    _mm_store_ps(value + 4, _mm_mul_ps(_mm_load_ps(value + 4)
+          , _mm_load_ps(other.value + 4)));
+#else
+    for(size_t i = 0; i < MAX_BANDS; ++i)
+    {
+      value[i] *= other.value[i];
+    }
+#endif
+    return *this;
+  }
+
+  BandEnergy &operator*=(const float &scale)
+  {
+#if ARMS_SSE2
+    const __m128 scalar = _mm_set1_ps(scale);
+    _mm_store_ps(value, _mm_mul_ps(_mm_load_ps(value), scalar));
+    _mm_store_ps(value + 4, _mm_mul_ps(_mm_load_ps(value + 4), scalar));
+#else
+    for(size_t i = 0; i < MAX_BANDS; ++i)
+    {
+      value[i] *= scale;
+    }
+#endif
+    return *this;
+  }
+
+  BandEnergy &operator+=(const BandEnergy &other)
+  {
+#if ARMS_SSE2
+    _mm_store_ps(value, _mm_add_ps(_mm_load_ps(value)
+          , _mm_load_ps(other.value)));
+    _mm_store_ps(value + 4, _mm_add_ps(_mm_load_ps(value + 4)
+          , _mm_load_ps(other.value + 4)));
+#else
+    for(size_t i = 0; i < MAX_BANDS; ++i)
+    {
+      value[i] += other.value[i];
+    }
+#endif
+    return *this;
+  }
+
+  /*!
+   *  Adds another value scaled by a constant (this += other * scale)
+   */
+  void add_scaled(const BandEnergy &other, const float &scale)
+  {
+#if ARMS_SSE2
+    const __m128 scalar = _mm_set1_ps(scale);
+    _mm_store_ps(value, _mm_add_ps(_mm_load_ps(value)
+          , _mm_mul_ps(_mm_load_ps(other.value), scalar)));
+    _mm_store_ps(value + 4, _mm_add_ps(_mm_load_ps(value + 4)
+          , _mm_mul_ps(_mm_load_ps(other.value + 4), scalar)));
+#else
+    for(size_t i = 0; i < MAX_BANDS; ++i)
+    {
+      value[i] += other.value[i] * scale;
+    }
+#endif
+  }
+
+  float &operator[](const size_t &band)
+  {
+    return value[band];
+  }
+
+  const float &operator[](const size_t &band) const
+  {
+    return value[band];
+  }
+
+  /*!
+   *  \param bandCount
+   *    The number of bands used by the grid
+   *
+   *  \returns
+   *    The average value of the used bands
+   */
+  float average(const size_t &bandCount) const
+  {
+    float sum = 0.f;
+    for(size_t i = 0; i < bandCount; ++i)
+    {
+      sum += value[i];
+    }
+
+    return (bandCount == 0) ? 1 : sum / bandCount;
+  }
+
+  float value[MAX_BANDS];
+};
+
+/*!
+ *  \class BandGrid
+ *
+ *  \brief
+ *    The octave bands a scene tracks energy in. The grid covers the
+ *    frequencies used by the scene's materials, up to BandEnergy::MAX_BANDS
+ *    octaves, and every material is resampled onto it once when the scene
+ *    is loaded so rays never have to match up frequencies while bouncing.
+ */
+class BandGrid
+{
+  public:
+    BandGrid();
+    ~BandGrid();
+
+    /*!
+     *  Builds the octave bands covering the absorbtion coefficents of every
+     *  object of a scene and the room walls
+     *
+     *  \param objVec
+     *    A vector of all objects in the scene
+     */
+    void build(const std::vector<Object *> &objVec);
+
+    size_t size() const;
+    /*!
+     *  \returns
+     *    The center frequency of a band
+     */
+    float get_frequency(const size_t &band) const;
+
+    /*!
+     *  Resamples absorbtion coefficents, given as (frequency, coefficent)
+     *  pairs, onto the grid. Coefficents are interpolated over log frequency
+     *  and held past the first and last frequency.
+     *
+     *  \param coefficents
+     *    The absorbtion coefficents of a material
+     *
+     *  \returns
+     *    The amount of energy reflected in each band (1 - absorbtion)
+     */
+    BandEnergy resample_reflection(const CoefficentArray &coefficents) const;
+
+  private:
+    // Octave centers are 1000Hz * 2^octave
+    static inline const int MIN_OCTAVE = -5;
+    static inline const int MAX_OCTAVE = 4;
+
+    std::vector<float> frequencies;
+};
@@ -45,11 +45,11 @@ class Barrier : public Object
     };
 
     // EMPTY CARRAY OF VEC2
-    static inline const CArray<Vec2> INVALID_COEFFICENT_VALUE;
+    static inline const CoefficentArray INVALID_COEFFICENT_VALUE;
 
     struct EQCoefficents
     {
-      CArray<Vec2> frequencyCoefficents;
+      CoefficentArray frequencyCoefficents;
       sf::Color color;
       std::string name;
     };
@@ -64,7 +64,7 @@ class Barrier : public Object
     static void set_custom_coefficent(const COEFFICENTS &index
         , const EQCoefficents &value);
     static COEFFICENTS get_coefficent_index(const std::string &name);
-    static const CArray<Vec2> &get_coefficent(const COEFFICENTS &index);
+    static const CoefficentArray &get_coefficent(const COEFFICENTS &index);
 
   private:
     COEFFICENTS type;
@@ -72,11 +72,11 @@ class Barrier : public Object
     static inline EQCoefficents EQCoefficentValues[C_COUNT] =
     {
       // Standard Coefficents
-      {CArray<Vec2>{{125, 0.28f}, {500, 0.17f}, {2000, 0.1f}, {4000, 0.15f}}
+      {CoefficentArray{{125, 0.28f}, {500, 0.17f}, {2000, 0.1f}, {4000, 0.15f}}
         , sf::Color{186, 140, 99}, "wood"}
-      , {CArray<Vec2>{{125, 0.04}, {500, 0.06}, {2000, 0.1f}, {4000, 0.15}}
+      , {CoefficentArray{{125, 0.04}, {500, 0.06}, {2000, 0.1f}, {4000, 0.15}}
         , sf::Color{255, 192, 203}, "rubber"}
-      , {CArray<Vec2>{{125, 0.18}, {500, 0.04}, {2000, 0.03f}, {4000, 0.02}}
+      , {CoefficentArray{{125, 0.18}, {500, 0.04}, {2000, 0.03f}, {4000, 0.02}}
         , sf::Color{100, 100, 100}, "wall"}
       // Custom Coefficents
       , {INVALID_COEFFICENT_VALUE, sf::Color{0, 0, 0}, ""}
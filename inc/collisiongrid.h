@@ -0,0 +1,128 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   collisiongrid.h
+ *
+ *  \brief
+ *    Interface of the uniform grid used to speed up ray collisions
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "arms_math.h"
+#include "edgetable.h"
+#include "intersect.h"
+
+/*!
+ *  \class CollisionGrid
+ *
+ *  \brief
+ *    A broad-phase index over the edges of a scene's EdgeTable.
+ *
+ *    The scene is split into a uniform grid of cells with each cell listing
+ *    the edges that overlap it. Rays walk the cells they pass through in
+ *    order (DDA) and only test the edges of those cells, stopping as soon as
+ *    a hit is found inside the current cell. This makes the cost of a bounce
+ *    depend on the objects near the ray rather than every object in the scene.
+ */
+class CollisionGrid
+{
+  public:
+    CollisionGrid();
+    ~CollisionGrid();
+
+    /*!
+     *  Builds the grid over every edge of a compiled edge table
+     *
+     *  NOTE: The table must outlive the grid as queries read from it
+     *
+     *  \param table
+     *    The edge table of the scene
+     */
+    void build(const EdgeTable &table);
+    void clear();
+
+    bool is_built() const;
+
+    /*!
+     *  Finds the closest edge hit by a ray segment
+     *
+     *  \param rayBegin
+     *    The position the ray starts at
+     *  \param rayEnd
+     *    The position the ray ends at
+     *  \param ignoreEdge
+     *    The edge the ray reflected off of
+     *  \param hitPos
+     *    Updated with the point of intersection if a hit occurs
+     *
+     *  \returns
+     *    The index of the edge that was hit or EdgeTable::NO_EDGE if there was
+     *    no hit
+     */
+    uint32_t find_closest_edge(const Vec2 &rayBegin, const Vec2 &rayEnd
+        , const uint32_t &ignoreEdge, Vec2 &hitPos) const;
+
+    /*!
+     *  Finds the closest edge hit by every ray of a packet. Each ray walks
+     *  its own cells but rays in the same cell test its edges together, so
+     *  the hits are exactly what find_closest_edge gives for each ray.
+     *
+     *  \param packet
+     *    The rays being traced
+     *  \param hits
+     *    Set to the closest hit of each ray of the packet
+     */
+    void find_closest_edges(const RayPacket &packet, PacketHits &hits) const;
+
+  private:
+    // State of a ray walking the cells of the grid (DDA)
+    struct CellWalk
+    {
+      int cellX, cellY;
+      int stepX, stepY;
+      // Ray distance to the next cell border on each axis
+      float tMaxX, tMaxY;
+      // Ray distance to cross a cell on each axis
+      float tDeltaX, tDeltaY;
+      // Ray distance at which the ray leaves the grid
+      float tExit;
+    };
+
+    void get_cell(const Vec2 &pos, int &cellX, int &cellY) const;
+    /*!
+     *  Clips a ray to the grid and starts its walk
+     *
+     *  \returns
+     *    False if the ray misses the grid
+     */
+    bool begin_walk(const Vec2 &rayBegin, const Vec2 &direction
+        , CellWalk &walk) const;
+    /*!
+     *  Moves a walk into the next cell along its ray
+     *
+     *  \returns
+     *    False if the ray has left the grid
+     */
+    bool step_walk(CellWalk &walk) const;
+    int get_walk_cell(const CellWalk &walk) const;
+    EdgeSpan get_cell_span(const int &cell) const;
+    static size_t first_lane(const uint32_t &mask);
+
+    const EdgeTable *table = nullptr;
+
+    Vec2 origin;
+    Vec2 cellSize;
+    int cellsX = 0, cellsY = 0;
+
+    // Cell contents are stored flat, with cell i owning the edge indicies
+    // from cellStart[i] up to cellStart[i + 1]
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellEdges;
+    // Copies of the edge endpoints in cell order so each cell can be tested
+    // as one contiguous run by the SIMD kernels
+    std::vector<float> cellBeginX, cellBeginY, cellEndX, cellEndY;
+};
@@ -0,0 +1,234 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   convolution.h
+ *
+ *  \brief
+ *    Interface of the partitioned convolution engines
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fft.h"
+
+/*!
+ *  \class UniformConvolver
+ *
+ *  \brief
+ *    Uniformly partitioned overlap-save convolution. The response is split
+ *    into partitions of one block each whose spectra are computed once. Every
+ *    block of input is transformed a single time and kept in a frequency
+ *    domain delay line, so each output block costs one forward FFT, one
+ *    inverse FFT and a multiply-add of every partition with the matching
+ *    input spectrum from the delay line.
+ *
+ *    Memory only depends on the length of the response and the cost of a
+ *    block is the same for any length of input, output is produced a block
+ *    at a time with no latency past the block itself.
+ */
+class UniformConvolver
+{
+  public:
+    UniformConvolver();
+    ~UniformConvolver();
+
+    /*!
+     *  Partitions a response, clearing any previous input
+     *
+     *  \param response
+     *    The samples of the impulse response
+     *  \param length
+     *    The number of samples of the response
+     *  \param _blockSize
+     *    The number of samples in each block, a power of two
+     */
+    void set_impulse_response(const float *response, const size_t &length
+        , const size_t &_blockSize);
+    /*!
+     *  Clears the input of previous blocks so a new signal can be convolved
+     */
+    void reset();
+
+    bool is_valid() const;
+    size_t get_block_size() const;
+    size_t get_partition_count() const;
+
+    /*!
+     *  Convolves the next block of input
+     *
+     *  \param input
+     *    get_block_size() samples of input
+     *  \param output
+     *    get_block_size() samples of output for the same block, may be the
+     *    same as input
+     */
+    void process_block(const float *input, float *output);
+
+  private:
+    size_t blockSize = 0;
+    size_t partitionCount = 0;
+    FFT fft;
+    // The spectrum of each partition, one after another
+    std::vector<Complex> partitions;
+    // The spectra of the last partitionCount blocks of input, a ring with
+    // the newest at delayHead
+    std::vector<Complex> delayLine;
+    size_t delayHead = 0;
+    // The previous and current block of input
+    std::vector<float> inputBuffer;
+    std::vector<Complex> spectrum;
+    std::vector<float> outputBuffer;
+};
+
+/*!
+ *  \class NonUniformConvolver
+ *
+ *  \brief
+ *    Low latency convolution for live playback. The head of the response is
+ *    convolved in short blocks as the input arrives, so the latency is only
+ *    a single short block. The rest of the response is split into segments
+ *    with blocks growing four times each segment, each convolved by its own
+ *    UniformConvolver on a background thread.
+ *
+ *    A segment with blocks of B samples starts at least 2B samples into the
+ *    response. Its block is complete B samples before any of its output is
+ *    needed, giving the background thread a whole block to finish it. The
+ *    audio thread never waits on the background thread: a late block is
+ *    counted and left out rather than stalling playback.
+ *
+ *    The threads never share a buffer. A segment only hands a block to the
+ *    background thread once it has finished the previous one, otherwise the
+ *    block is dropped and its input written over. The background thread only
+ *    writes the segment's work buffer, which the audio thread copies into
+ *    its output ring once the block is complete.
+ */
+class NonUniformConvolver
+{
+  public:
+    // 5.8ms at 44100Hz
+    static inline const size_t HEAD_BLOCK_SIZE = 256;
+    static inline const size_t MAX_BLOCK_SIZE = 16384;
+
+    NonUniformConvolver();
+    ~NonUniformConvolver();
+
+    /*!
+     *  Partitions a response and starts the background thread, clearing any
+     *  previous input
+     *
+     *  \param response
+     *    The samples of the impulse response
+     *  \param length
+     *    The number of samples of the response
+     *  \param threaded
+     *    If the tail is convolved on a background thread, otherwise it is
+     *    convolved as soon as its block is complete which is only useful
+     *    when rendering offline
+     */
+    void set_impulse_response(const float *response, const size_t &length
+        , const bool &threaded = true);
+    /*!
+     *  Stops the background thread and removes the response
+     */
+    void clear();
+
+    bool is_valid() const;
+    /*!
+     *  \returns
+     *    The number of samples of each block passed to process_block, which
+     *    is also the latency
+     */
+    size_t get_block_size() const;
+    /*!
+     *  \returns
+     *    The number of times part of the tail wasn't finished in time and was
+     *    left out of the output
+     */
+    size_t get_missed_blocks() const;
+
+    /*!
+     *  Convolves the next block of input, this never waits on the background
+     *  thread so it is safe to call from an audio callback
+     *
+     *  \param input
+     *    get_block_size() samples of input
+     *  \param output
+     *    get_block_size() samples of output, may be the same as input
+     */
+    void process_block(const float *input, float *output);
+    /*!
+     *  Makes the background thread wait before every block it convolves,
+     *  i.e. to check a background thread that can't keep up only leaves
+     *  blocks out of the output
+     *
+     *  \param microseconds
+     *    The time waited before each block, 0 doesn't wait
+     */
+    void delay_background(const unsigned &microseconds);
+
+  private:
+    struct Segment
+    {
+      UniformConvolver engine;
+      // Where the segment starts in the response
+      size_t offset = 0;
+      size_t blockSize = 0;
+      // Two blocks of input, the audio thread fills one while the background
+      // thread convolves the other
+      std::vector<float> inputBlocks;
+      size_t filled = 0;
+      size_t fillHalf = 0;
+      size_t workHalf = 0;
+      // The number of blocks of input so far
+      size_t blockCount = 0;
+      // Convolved output waiting to be played, indexed by the time it plays,
+      // along with the block each part of the ring holds plus one. Only the
+      // audio thread uses them.
+      std::vector<float> outputRing;
+      size_t ringMask = 0;
+      std::vector<size_t> ringBlocks;
+      // The output of the block handed to the background thread
+      std::vector<float> work;
+      size_t workBlock = 0;
+      bool collected = true;
+      // Set when a block was dropped so the engine's history is cleared
+      // rather than joining blocks that aren't next to each other
+      bool dropped = false;
+      bool resetEngine = false;
+      // Blocks handed to the background thread and blocks it has finished
+      std::atomic<size_t> requested{0};
+      std::atomic<size_t> completed{0};
+    };
+
+    /*!
+     *  Convolves the block in the segment's work half into its work buffer
+     */
+    void convolve_segment_block(Segment &segment);
+    /*!
+     *  Copies a finished block from the work buffer into the output ring,
+     *  only called by the audio thread
+     */
+    void collect_segment_block(Segment &segment);
+    void run_background();
+
+    UniformConvolver head;
+    std::vector<std::unique_ptr<Segment>> segments;
+    // The number of samples processed
+    size_t time = 0;
+    bool threaded = true;
+
+    std::thread background;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> running{false};
+    std::atomic<size_t> missedBlocks{0};
+    std::atomic<unsigned> backgroundDelay{0};
+};
@@ -0,0 +1,119 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   edgetable.h
+ *
+ *  \brief
+ *    Interface of the flat edge table the ray tracer collides against
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "arms_math.h"
+#include "bandgrid.h"
+#include "helper.h"
+
+class Object;
+class Listener;
+
+/*!
+ *  \class EdgeTable
+ *
+ *  \brief
+ *    The geometry of a scene compiled into flat arrays (structure of arrays)
+ *    so the tracer never has to rebuild object corners, compare type names
+ *    or cast objects while bouncing rays.
+ *
+ *    Every object except the source adds its four edges in scene order,
+ *    followed by the four walls of the room. The table is immutable once
+ *    compiled.
+ */
+class EdgeTable
+{
+  public:
+    enum EDGE_KIND
+    {
+      EK_BARRIER = 0
+      , EK_LISTENER
+      , EK_WALL
+    };
+
+    // Used when a ray has no edge it reflected off of (i.e. inital rays)
+    static inline const uint32_t NO_EDGE = 0xFFFFFFFFu;
+
+    EdgeTable();
+    ~EdgeTable();
+
+    /*!
+     *  Compiles the edges of the scene's objects and the room walls into
+     *  the table, replacing any previous contents
+     *
+     *  \param objVec
+     *    A vector of all objects in the scene
+     *  \param roomPos
+     *    The top left position of the room
+     *  \param roomSize
+     *    The size of the room
+     *  \param scalar
+     *    The scalar from physical space into the scene, used to compute the
+     *    physical normal of each edge
+     *  \param grid
+     *    The bands of the scene, every material is resampled onto it
+     */
+    void compile(const std::vector<Object *> &objVec, const Vec2 &roomPos
+        , const Vec2 &roomSize, const Vec2 &scalar, const BandGrid &grid);
+    void clear();
+
+    size_t size() const;
+    /*!
+     *  \returns
+     *    The number of bands of the grid the table was compiled with
+     */
+    size_t get_band_count() const;
+
+    Vec2 get_begin(const uint32_t &edge) const;
+    Vec2 get_end(const uint32_t &edge) const;
+    Vec2 get_normal(const uint32_t &edge) const;
+    EDGE_KIND get_kind(const uint32_t &edge) const;
+    int get_line(const uint32_t &edge) const;
+    /*!
+     *  \returns
+     *    The object that owns the edge or nullptr for the room walls
+     */
+    Object *get_owner(const uint32_t &edge) const;
+    /*!
+     *  \returns
+     *    The listener owning the edge, only valid for EK_LISTENER edges
+     */
+    Listener *get_listener(const uint32_t &edge) const;
+    /*!
+     *  \returns
+     *    The amount of energy the edge reflects in each band
+     */
+    const BandEnergy &get_material(const uint32_t &edge) const;
+
+    // Edge endpoints
+    std::vector<float> beginX, beginY, endX, endY;
+    // Physical space unit normals
+    std::vector<float> normalX, normalY;
+    std::vector<uint16_t> materialId;
+    std::vector<uint8_t> kind;
+    std::vector<uint8_t> line;
+    std::vector<Object *> owner;
+
+  private:
+    void add_edges(Object *obj, const Vec2 &pos, const Vec2 &size
+        , const EDGE_KIND &edgeKind, const uint16_t &material
+        , const Vec2 &scalar);
+    uint16_t add_material(const CoefficentArray &coefficents, const int &key
+        , const BandGrid &grid);
+
+    // Reflection factors of each unique material, with the key used to find
+    // already added materials (barrier types share a material)
+    std::vector<BandEnergy> materials;
+    std::vector<int> materialKeys;
+    size_t bandCount = 0;
+};
@@ -0,0 +1,99 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   fft.h
+ *
+ *  \brief
+ *    Interface of the fast fourier transform used for convolution
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using Complex = std::complex<float>;
+
+/*!
+ *  \class FFT
+ *
+ *  \brief
+ *    A radix-2 fast fourier transform of a fixed power of two size. The
+ *    twiddle factors and bit reversal table are computed once so the same
+ *    FFT can transform any number of blocks.
+ *
+ *    Real signals of size samples are transformed through a complex FFT of
+ *    half the size and have size / 2 + 1 bins, the rest of the spectrum being
+ *    the conjugate of those bins.
+ */
+class FFT
+{
+  public:
+    FFT(const size_t &_size = 0);
+    ~FFT();
+
+    /*!
+     *  Sets the number of real samples transformed
+     *
+     *  \param _size
+     *    A power of two of at least 2
+     */
+    void resize(const size_t &_size);
+    size_t size() const;
+    /*!
+     *  \returns
+     *    The number of bins of a transformed real signal, size / 2 + 1
+     */
+    size_t get_bin_count() const;
+
+    /*!
+     *  Transforms real samples into their spectrum
+     *
+     *  \param input
+     *    size() samples
+     *  \param output
+     *    get_bin_count() bins
+     */
+    void forward(const float *input, Complex *output) const;
+    /*!
+     *  Transforms a spectrum back into real samples, scaled so that
+     *  inverse(forward(x)) is x
+     *
+     *  \param input
+     *    get_bin_count() bins, which are overwritten
+     *  \param output
+     *    size() samples
+     */
+    void inverse(Complex *input, float *output) const;
+
+    /*!
+     *  \returns
+     *    The smallest power of two of at least value
+     */
+    static size_t get_power_of_two(const size_t &value);
+
+  private:
+    /*!
+     *  An in place complex FFT of half the real size
+     */
+    void transform(Complex *data, const bool &inverse) const;
+
+    size_t count = 0;
+    // e^(-2 pi i k / (count / 2)) for the complex FFT
+    std::vector<Complex> twiddles;
+    // e^(-2 pi i k / count) to split and join the real spectrum
+    std::vector<Complex> realTwiddles;
+    std::vector<uint32_t> bitReverse;
+};
+
+/*!
+ *  Multiplies two complex values without the checks for infinities the
+ *  standard library does
+ */
+inline Complex complex_multiply(const Complex &a, const Complex &b)
+{
+  return Complex(a.real() * b.real() - a.imag() * b.imag()
+      , a.real() * b.imag() + a.imag() * b.real());
+}
@@ -12,10 +12,51 @@
 #include <vector>
 #include <cstdint>
 
+#include "audiobuffer.h"
+#include "convolution.h"
 #include "helper.h"
+#include "taps.h"
 
-typedef struct SAMPLES SAMPLES;
+/*!
+ *  \struct BIQUAD_LANES
+ *
+ *  \brief
+ *    The biquads of up to 8 band passes sharing the same input, one band per
+ *    lane, along with their state so a signal can be run through them a
+ *    block at a time. Unused lanes are all zero so they never add to the
+ *    output.
+ */
+struct BIQUAD_LANES
+{
+  static inline const size_t LANES = 8;
 
+  alignas(32) float b0[LANES] = {};
+  alignas(32) float b1[LANES] = {};
+  alignas(32) float b2[LANES] = {};
+  alignas(32) float a1[LANES] = {};
+  alignas(32) float a2[LANES] = {};
+  alignas(32) float gain[LANES] = {};
+
+  // The input is the same for every lane so only the outputs are per lane
+  float x1 = 0.f, x2 = 0.f;
+  alignas(32) float y1[LANES] = {};
+  alignas(32) float y2[LANES] = {};
+
+  void reset();
+};
+
+/*!
+ *  \class Filter
+ *
+ *  \brief
+ *    The base of every filter. A signal can either be filtered whole with
+ *    apply_filter or streamed through process_block a block at a time, the
+ *    filter keeping its state between blocks so inputs of any length can be
+ *    filtered in fixed memory.
+ *
+ *    The base filter mixes delayed copies of the input set by its
+ *    coefficents.
+ */
 class Filter
 {
   protected:
@@ -39,10 +80,32 @@ class Filter
 
     virtual void add_coefficent(const COEFFICENT &coefficent);
 
-    virtual void apply_filter(CArray<float> &samples);
+    virtual void apply_filter(AudioBuffer &samples);
+    /*!
+     *  Clears the state kept between blocks so a new signal can be streamed
+     */
+    virtual void reset();
+    /*!
+     *  Filters the next block of a signal. The output is as long as the
+     *  input, anything delayed past the end of the block comes out of later
+     *  blocks.
+     *
+     *  \param input
+     *    count samples of input
+     *  \param output
+     *    count samples of output, may be the same as input
+     *  \param count
+     *    The number of samples in the block
+     */
+    virtual void process_block(const float *input, float *output
+        , const size_t &count);
 
   private:
-    std::vector<COEFFICENT> coefficents;
+    MultiTapDelay taps;
+    // Delayed output that lands past the blocks processed so far, a ring
+    // starting at pendingHead
+    AudioBuffer pending;
+    size_t pendingHead = 0;
 };
 
 class LowPass : public Filter
@@ -74,9 +137,11 @@ class BandPass : public Filter
     BandPass(const float &_frequency = 0.f, const float &_quality = 1.f
         , const float &_samplingRate = 0.f);
     BandPass(const BandPass &other);
+    BandPass(BandPass &&other) noexcept;
     ~BandPass();
 
     BandPass &operator=(const BandPass &other);
+    BandPass &operator=(BandPass &&other) noexcept;
 
     void set_quality(const float &_quality);
     void set_gain(const float &gain);
@@ -87,16 +152,41 @@ class BandPass : public Filter
     bool is_valid() const;
 
     const float &get_sampling_rate() const;
+    const float &get_gain() const;
+    /*!
+     *  Gets the coefficents normalized to a0, update_values must be called
+     *  first for them to match the current settings
+     */
+    void get_coefficents(float &_b0, float &_b1, float &_b2, float &_a1
+        , float &_a2) const;
+    /*!
+     *  \returns
+     *    The number of samples the band keeps ringing for after its input
+     *    stops, until it has decayed by 60 dB
+     */
+    size_t get_decay_length() const;
 
-    void apply_filter(CArray<float> &samples) override;
+    void apply_filter(AudioBuffer &samples) override;
+    void reset() override;
+    void process_block(const float *input, float *output
+        , const size_t &count) override;
   private:
     float samplingRate;
     float frequency;
     float quality;
     float gain;
     float a0, a1, a2, b0, b1, b2;
+    float x1 = 0.f, x2 = 0.f, y1 = 0.f, y2 = 0.f;
 };
 
+/*!
+ *  \class Equalizer
+ *
+ *  \brief
+ *    A bank of band passes over the same input summed into a delayed output.
+ *    The bands are run side by side in the lanes of a single pass over the
+ *    input, up to 8 at a time, rather than one full pass per band.
+ */
 class Equalizer : public Filter
 {
   public:
@@ -106,21 +196,159 @@ class Equalizer : public Filter
         , const float &_samplingRate = 0.
         , const float &delay = 0.f);
     Equalizer(const Equalizer &other);
+    Equalizer(Equalizer &&other) noexcept;
     ~Equalizer();
 
     Equalizer &operator=(const Equalizer &other);
+    Equalizer &operator=(Equalizer &&other) noexcept;
 
     void calculate_quality(const uint8_t &quanity);
+    const float &get_quality() const;
 
     void add_coefficent(const float &frequency, const float &coefficent
         , const size_t &band);
-    void apply_filter(CArray<float> &samples) override;
+    void apply_filter(AudioBuffer &samples) override;
+    void reset() override;
+    void process_block(const float *input, float *output
+        , const size_t &count) override;
     void set_delay(const float &delay);
 
   private:
+    /*!
+     *  Runs every band over the input, carrying on from the state of the
+     *  previous call, and adds the bands into the output
+     */
+    void run_bands(const float *input, const size_t &count, float *output);
+
     uint8_t bandMax;
     float delay;
     float quality;
     float samplingRate;
     CArray<BandPass> bands;
+    // Groups of 8 bands run together and their state between blocks
+    std::vector<BIQUAD_LANES> laneGroups;
+    // Output waiting out the delay, a ring starting at delayHead
+    AudioBuffer delayLine;
+    size_t delayHead = 0;
+    AudioBuffer work;
+};
+
+/*!
+ *  \class FilterBank
+ *
+ *  \brief
+ *    Mixes many delayed and equalized copies of the same input. The input is
+ *    band passed once per band and every copy becomes a delay and a gain in
+ *    each band, rather than every copy band passing the input itself like an
+ *    Equalizer per copy would.
+ *
+ *    The bands match an Equalizer with the same number of bands, so the
+ *    output is the same as summing an Equalizer for each copy.
+ */
+class FilterBank : public Filter
+{
+  public:
+    // NOTE: SamplingRate defaults to 0 so that we can detect when invalid
+    // FilterBanks are created
+    FilterBank(const uint8_t &bandCount = 0, const float &_samplingRate = 0.f);
+    ~FilterBank();
+
+    void set_frequency(const size_t &band, const float &frequency);
+    /*!
+     *  Adds a delayed copy of the input
+     *
+     *  \param delay
+     *    The delay of the copy in samples
+     *  \param gains
+     *    The gain of the copy in each band
+     */
+    void add_tap(const unsigned &delay, const float *gains);
+    size_t get_band_count() const;
+    /*!
+     *  \returns
+     *    The delay of the longest tap in samples
+     */
+    unsigned get_max_delay() const;
+    /*!
+     *  \returns
+     *    The number of samples the output goes on for past the input, the
+     *    longest tap and the ringing of the slowest band
+     */
+    size_t get_tail_length() const;
+    void clear();
+
+    void apply_filter(AudioBuffer &samples) override;
+    void reset() override;
+    void process_block(const float *input, float *output
+        , const size_t &count) override;
+
+  private:
+    /*!
+     *  Prepares the taps of every band, called before they are mixed so the
+     *  taps can be added in any order
+     */
+    void prepare_taps();
+
+    float samplingRate;
+    CArray<BandPass> bands;
+    // The taps of each band
+    std::vector<MultiTapDelay> taps;
+    // Mixed output that lands past the blocks processed so far, a ring
+    // starting at pendingHead
+    AudioBuffer pending;
+    size_t pendingHead = 0;
+    AudioBuffer band;
+};
+
+/*!
+ *  \class Convolver
+ *
+ *  \brief
+ *    Convolves samples with an impulse response, the output is as long as the
+ *    input and the response combined so the tail of the response is kept.
+ *
+ *    Long responses are convolved in fixed blocks by a UniformConvolver, so
+ *    the cost of each block doesn't depend on how dense the response is and
+ *    memory stays bounded for responses of several seconds.
+ */
+class Convolver : public Filter
+{
+  public:
+    // Responses up to this length are convolved directly
+    static inline const size_t DIRECT_LENGTH = 64;
+    // The largest block longer responses are partitioned into
+    static inline const size_t MAX_BLOCK_SIZE = 4096;
+
+    Convolver();
+    ~Convolver();
+
+    void set_impulse_response(const AudioBuffer &response);
+    size_t get_length() const;
+    const AudioBuffer &get_impulse_response() const;
+    /*!
+     *  \returns
+     *    The number of samples process_block must be given a multiple of
+     */
+    size_t get_block_size() const;
+
+    void apply_filter(AudioBuffer &samples) override;
+    void reset() override;
+    /*!
+     *  Convolves the next block of a signal, count must be a multiple of
+     *  get_block_size()
+     */
+    void process_block(const float *input, float *output
+        , const size_t &count) override;
+
+  private:
+    void apply_direct(const AudioBuffer &samples, AudioBuffer &output) const;
+    void apply_partitioned(const AudioBuffer &samples
+        , AudioBuffer &output);
+
+    AudioBuffer impulseResponse;
+    UniformConvolver engine;
+    // The tail of short responses past the blocks processed so far, a ring
+    // starting at pendingHead
+    AudioBuffer pending;
+    size_t pendingHead = 0;
 };
@@ -13,6 +13,10 @@
 
 #include "parsedata.h"
 #include "arms_math.h"
+#include "collisiongrid.h"
+#include "edgetable.h"
+#include "raypaths.h"
+#include "receiver.h"
 
 const Vec2 DEFAULT_ROOM_SIZE = {1000.f, 1000.f};
 const float DEFAULT_RAY_DISTANCE = std::sqrt(DEFAULT_ROOM_SIZE.x 
@@ -21,22 +25,36 @@ const float DEFAULT_RAY_DISTANCE = std::sqrt(DEFAULT_ROOM_SIZE.x
 struct CollisionInfo
 {
   CollisionInfo()
-    : collision(false), parent(nullptr), parentLine(0)
-      , lineBegin({0.f, 0.f}), lineEnd({0.f, 0.f})
+    : collision(false), edge(EdgeTable::NO_EDGE)
   {
   }
-  CollisionInfo(bool _collision, Object *_parent, int _parentLine
-      , const Vec2 &_lineBegin, const Vec2 &_lineEnd)
-    : collision(_collision), parent(_parent), parentLine(_parentLine)
-      , lineBegin(_lineBegin), lineEnd(_lineEnd)
+  CollisionInfo(bool _collision, uint32_t _edge)
+    : collision(_collision), edge(_edge)
   {
   }
 
   bool collision;
-  Object *parent;
-  int parentLine;
-  Vec2 lineBegin;
-  Vec2 lineEnd;
+  // The index of the edge that was hit within the scene's EdgeTable
+  uint32_t edge;
+};
+
+/*!
+ *  \struct RayGenerationInfo
+ *
+ *  \brief
+ *    User tweakable settings for how the rays of a scene are traced
+ */
+struct RayGenerationInfo
+{
+  // Number of worker threads used to trace the inital rays, 0 will use the
+  // number of hardware threads available
+  unsigned threadCount = 0u;
+  // Use the scene's collision grid, otherwise every object is checked for
+  // every bounce (brute force) which is useful for comparing results
+  bool useCollisionGrid = true;
+  // Number of neighbouring inital rays traced together as a packet, from 4
+  // up to 16. 0 or 1 traces every ray on its own.
+  unsigned packetSize = 8u;
 };
 
 /*!
@@ -58,6 +76,33 @@ std::array<Vec2, 2> get_object_data(DataMap::DataMapIterator it);
 std::vector<Object *> convert_DataMap_to_Object(DataMap *dataMap
     , const Vec2 &posOffset, const Vec2 &scalar);
 
-std::vector<std::vector<AudioRay *>> generate_audio_rays_from_scene(
-    std::vector<Object *> &objVec, const Vec2 &relativePos
-    , const Vec2& relativeSize, const Vec2 &scalar);
+/*!
+ *  Traces every inital ray of the scene's source until it either hits the
+ *  listener, runs out of checks or falls below the source's threshold. Rays
+ *  are independent so they are split into contiguous ranges and traced by a
+ *  pool of worker threads, each with its own output, which are then merged
+ *  in range order so the result is the same for any thread count.
+ *
+ *  \param objVec
+ *    A vector of all objects in the scene
+ *  \param table
+ *    The compiled edges of the scene's objects and walls
+ *  \param scalar
+ *    The scalar from physical space into the scene
+ *  \param info
+ *    Settings for how the rays are traced
+ *  \param grid
+ *    The collision grid built over the table, if nullptr the rays will use
+ *    brute force collision checks
+ *  \param histogram
+ *    Records the energy passing through the listener when it is a
+ *    volumetric receiver, in which case no paths are kept
+ *
+ *  \returns
+ *    The paths of every ray that hit the listener
+ */
+RayPaths generate_audio_rays_from_scene(
+    const std::vector<Object *> &objVec, const EdgeTable &table
+    , const Vec2 &scalar, const RayGenerationInfo &info = RayGenerationInfo()
+    , const CollisionGrid *grid = nullptr
+    , EnergyHistogram *histogram = nullptr);
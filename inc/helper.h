@@ -12,6 +12,7 @@
 #include <cstddef>
 #include <iostream>
 #include <string>
+#include <utility>
 #include <memory.h>
 
 #include "arms_math.h"
@@ -49,6 +50,17 @@ class Logger
     std::string logMessage;
 };
 
+/*!
+ *  \class CArray
+ *
+ *  \brief
+ *    A C-Style array that tracks its own size. The size is the number of
+ *    values in use and the capacity the number allocated, so growing within
+ *    the capacity, i.e. with push_back, doesn't reallocate.
+ *
+ *    operator[] grows the array when given an index past its end, data()
+ *    gives unchecked access for hot loops.
+ */
 template <typename T>
 class CArray
 {
@@ -59,7 +71,7 @@ class CArray
     }
 
     CArray(const size_t &initalcount)
-      : head(new T[initalcount]{}), count(initalcount)
+      : head(new T[initalcount]{}), count(initalcount), reserved(initalcount)
     {
     }
 
@@ -69,6 +81,20 @@ class CArray
       *this = other;
     }
 
+    /*!
+     *  Takes the values of another array, leaving it empty
+     *
+     *  \param other
+     *    The array being moved from
+     */
+    CArray(CArray &&other) noexcept
+      : head(other.head), count(other.count), reserved(other.reserved)
+    {
+      other.head = nullptr;
+      other.count = 0;
+      other.reserved = 0;
+    }
+
     /*!
      *  Creates a C-Style array with a std::initializer_list
      *
@@ -77,6 +103,7 @@ class CArray
      */
     CArray(std::initializer_list<T> array)
       : head(new T[array.size()]{}), count(array.size())
+      , reserved(array.size())
     {
       size_t i = 0;
       for(const T &value : array)
@@ -97,14 +124,20 @@ class CArray
         return *this;
       }
 
-      clear();
-
       if(other.count == 0)
       {
+        clear();
         return *this;
       }
 
-      resize(other.count);
+      // The current allocation is reused when it is large enough
+      if(other.count > reserved)
+      {
+        clear();
+        head = new T[other.count];
+        reserved = other.count;
+      }
+      count = other.count;
 
       for(size_t i = 0; i < count; ++i)
       {
@@ -114,6 +147,25 @@ class CArray
       return *this;
     }
 
+    CArray &operator=(CArray &&other) noexcept
+    {
+      if(this == &other)
+      {
+        return *this;
+      }
+
+      clear();
+
+      head = other.head;
+      count = other.count;
+      reserved = other.reserved;
+      other.head = nullptr;
+      other.count = 0;
+      other.reserved = 0;
+
+      return *this;
+    }
+
 
     CArray &operator+=(const CArray &other)
     {
@@ -150,10 +202,34 @@ class CArray
       return count;
     }
 
+    /*!
+     *  \returns
+     *    The number of values allocated
+     */
+    const size_t &capacity() const
+    {
+      return reserved;
+    }
+
     const T *front() const
     {
       return head;
     }
+
+    /*!
+     *  \returns
+     *    A pointer to the values for unchecked access, only the first size()
+     *    are valid
+     */
+    T *data()
+    {
+      return head;
+    }
+
+    const T *data() const
+    {
+      return head;
+    }
   
     T &operator[](const size_t &index)
     {
@@ -198,6 +274,13 @@ class CArray
       resize(count * 2);
     }
 
+    /*!
+     *  Resizes the array, new values are value initialized. The array is only
+     *  reallocated when growing past its capacity.
+     *
+     *  \param newSize
+     *    The new number of values, 0 frees the array
+     */
     void resize(const size_t &newSize)
     {
       if(newSize == 0)
@@ -206,22 +289,67 @@ class CArray
         return;
       }
 
-      T *newHead = new T[newSize]{};
+      reserve(newSize);
+
+      for(size_t i = count; i < newSize; ++i)
+      {
+        head[i] = T{};
+      }
 
-      size_t copyCount = (count < newSize) ? count : newSize;
+      count = newSize;
+    }
 
-      if(head && count > 0)
+    /*!
+     *  Makes sure the array can hold a number of values without reallocating,
+     *  the size stays the same
+     *
+     *  \param newCapacity
+     *    The number of values to allocate for
+     */
+    void reserve(const size_t &newCapacity)
+    {
+      if(newCapacity <= reserved)
       {
-        for(size_t i = 0; i < copyCount; ++i)
-        {
-          newHead[i] = head[i];
-        }
+        return;
       }
 
-      clear();
+      // Values past the size are set by resize or push_back before use
+      T *newHead = new T[newCapacity];
+      for(size_t i = 0; i < count; ++i)
+      {
+        newHead[i] = std::move(head[i]);
+      }
 
+      delete []head;
       head = newHead;
-      count = newSize;
+      reserved = newCapacity;
+    }
+
+    /*!
+     *  Adds a value to the end of the array, doubling the capacity when it is
+     *  full so adding n values only reallocates log(n) times
+     *
+     *  \param value
+     *    The value being added
+     */
+    void push_back(const T &value)
+    {
+      if(count == reserved)
+      {
+        reserve((reserved == 0) ? 1 : reserved * 2);
+      }
+
+      head[count++] = value;
+    }
+
+    void push_back(T &&value)
+    {
+      if(count == reserved)
+      {
+        reserve((reserved == 0) ? 1 : reserved * 2);
+      }
+
+      head[count++] = std::move(value);
     }
 
     void clear()
@@ -239,13 +367,293 @@ class CArray
       }
 
       count = 0;
+      reserved = 0;
     }
 
   private:
     size_t count;
     T *head;
+    size_t reserved = 0;
+};
+
+/*!
+ *  \class SmallArray
+ *
+ *  \brief
+ *    A CArray that keeps up to N values inside itself, only allocating once
+ *    it grows past them. Small arrays that are made and copied often, like
+ *    the coefficents of every band, then never touch the heap.
+ *
+ *    It is used the same as a CArray, operator[] grows the array when given
+ *    an index past its end.
+ */
+template <typename T, size_t N>
+class SmallArray
+{
+  public:
+    SmallArray()
+    {
+    }
+
+    SmallArray(const size_t &initalcount)
+    {
+      resize(initalcount);
+    }
+
+    SmallArray(const SmallArray &other)
+    {
+      *this = other;
+    }
+
+    /*!
+     *  Takes the values of another array, leaving it empty. Values kept
+     *  inline are moved one at a time, allocated ones are taken whole.
+     *
+     *  \param other
+     *    The array being moved from
+     */
+    SmallArray(SmallArray &&other) noexcept
+    {
+      *this = std::move(other);
+    }
+
+    SmallArray(std::initializer_list<T> array)
+    {
+      reserve(array.size());
+      for(const T &value : array)
+      {
+        head[count++] = value;
+      }
+    }
+
+    ~SmallArray()
+    {
+      clear();
+    }
+
+    SmallArray &operator=(const SmallArray &other)
+    {
+      if(this == &other)
+      {
+        return *this;
+      }
+
+      if(other.count > reserved)
+      {
+        clear();
+        reserve(other.count);
+      }
+      count = other.count;
+
+      for(size_t i = 0; i < count; ++i)
+      {
+        head[i] = other.head[i];
+      }
+
+      return *this;
+    }
+
+    SmallArray &operator=(SmallArray &&other) noexcept
+    {
+      if(this == &other)
+      {
+        return *this;
+      }
+
+      clear();
+
+      if(other.is_inline())
+      {
+        for(size_t i = 0; i < other.count; ++i)
+        {
+          local[i] = std::move(other.local[i]);
+        }
+        count = other.count;
+        other.count = 0;
+        return *this;
+      }
+
+      head = other.head;
+      count = other.count;
+      reserved = other.reserved;
+      other.head = other.local;
+      other.count = 0;
+      other.reserved = N;
+
+      return *this;
+    }
+
+
+    const size_t &size() const
+    {
+      return count;
+    }
+
+    /*!
+     *  \returns
+     *    The number of values held without reallocating, at least N
+     */
+    const size_t &capacity() const
+    {
+      return reserved;
+    }
+
+    /*!
+     *  \returns
+     *    If the values are kept inside the array rather than allocated
+     */
+    bool is_inline() const
+    {
+      return head == local;
+    }
+
+    const T *front() const
+    {
+      return head;
+    }
+
+    T *data()
+    {
+      return head;
+    }
+
+    const T *data() const
+    {
+      return head;
+    }
+
+    T &operator[](const size_t &index)
+    {
+      if(index >= count)
+      {
+        resize((index + 1) * 2);
+      }
+
+      return head[index];
+    }
+
+    const T &at(const size_t &index) const
+    {
+      if(count == 0)
+      {
+        throw "Calling at() when no valid value in SmallArray";
+      }
+
+      if(index >= count)
+      {
+        return head[count - 1];
+      }
+
+      return head[index];
+    }
+
+
+    void resize()
+    {
+      resize(count * 2);
+    }
+
+    /*!
+     *  Resizes the array, new values are value initialized. Only growing past
+     *  the capacity reallocates.
+     *
+     *  \param newSize
+     *    The new number of values, 0 empties the array and frees anything
+     *    allocated
+     */
+    void resize(const size_t &newSize)
+    {
+      if(newSize == 0)
+      {
+        clear();
+        return;
+      }
+
+      reserve(newSize);
+
+      for(size_t i = count; i < newSize; ++i)
+      {
+        head[i] = T{};
+      }
+
+      count = newSize;
+    }
+
+    /*!
+     *  Makes sure the array can hold a number of values without reallocating,
+     *  moving the values onto the heap once there are more than N
+     *
+     *  \param newCapacity
+     *    The number of values to make room for
+     */
+    void reserve(const size_t &newCapacity)
+    {
+      if(newCapacity <= reserved)
+      {
+        return;
+      }
+
+      T *newHead = new T[newCapacity];
+      for(size_t i = 0; i < count; ++i)
+      {
+        newHead[i] = std::move(head[i]);
+      }
+
+      if(!is_inline())
+      {
+        delete []head;
+      }
+      head = newHead;
+      reserved = newCapacity;
+    }
+
+    void push_back(const T &value)
+    {
+      if(count == reserved)
+      {
+        reserve(reserved * 2);
+      }
+
+      head[count++] = value;
+    }
+
+    void push_back(T &&value)
+    {
+      if(count == reserved)
+      {
+        reserve(reserved * 2);
+      }
+
+      head[count++] = std::move(value);
+    }
+
+    void clear()
+    {
+      if(!is_inline())
+      {
+        delete []head;
+        head = local;
+      }
+
+      count = 0;
+      reserved = N;
+    }
+
+  private:
+    T local[N];
+    // Points at local until the array grows past N values
+    T *head = local;
+    size_t count = 0;
+    size_t reserved = N;
 };
 
+/*!
+ *  The absorbtion coefficents of a material or the amplitude of a ray, as
+ *  (frequency, coefficent) pairs. Scenes have at most BandEnergy::MAX_BANDS
+ *  bands so they stay inline.
+ */
+using CoefficentArray = SmallArray<Vec2, 8>;
+
 // FIFO
 template<typename T>
 class CQueue
@@ -267,6 +675,15 @@ class CQueue
       *this = other;
     }
 
+    CQueue(CQueue &&other) noexcept
+      : front_(other.front_), back_(other.back_), count_(other.count_)
+      , array(std::move(other.array))
+    {
+      other.front_ = 0;
+      other.back_ = 0;
+      other.count_ = 0;
+    }
+
     ~CQueue()
     {
       clear();
@@ -282,6 +699,25 @@ class CQueue
       array = other.array;
       front_ = other.front_;
       back_ = other.back_;
+      count_ = other.count_;
+
+      return *this;
+    }
+
+    CQueue &operator=(CQueue &&other) noexcept
+    {
+      if(this == &other)
+      {
+        return *this;
+      }
+
+      array = std::move(other.array);
+      front_ = other.front_;
+      back_ = other.back_;
+      count_ = other.count_;
+      other.front_ = 0;
+      other.back_ = 0;
+      other.count_ = 0;
 
       return *this;
     }
@@ -289,12 +725,12 @@ class CQueue
 
     const T &front() const
     {
-      return array[front_];
+      return array.at(front_);
     }
 
     const T &back() const
     {
-      return array[back_];
+      return array.at(back_);
     }
 
     size_t size() const
@@ -302,6 +738,29 @@ class CQueue
       return count_;
     }
 
+    /*!
+     *  \returns
+     *    The number of values the queue holds before it has to grow
+     */
+    size_t capacity() const
+    {
+      return array.size();
+    }
+
+    /*!
+     *  Makes sure the queue can hold a number of values without growing
+     *
+     *  \param newCapacity
+     *    The number of values to make room for
+     */
+    void reserve(const size_t &newCapacity)
+    {
+      if(newCapacity > array.size())
+      {
+        resize(newCapacity);
+      }
+    }
+
   
     void push(const T &value)
     {
@@ -310,8 +769,20 @@ class CQueue
         resize();
       }
 
-      array[back_] = value;
-      back_ = (back_ + 1) % ((array.size() == 0) ? 1 : array.size());
+      array.data()[back_] = value;
+      back_ = (back_ + 1) % array.size();
+      ++count_;
+    }
+
+    void push(T &&value)
+    {
+      if(count_ == array.size())
+      {
+        resize();
+      }
+
+      array.data()[back_] = std::move(value);
+      back_ = (back_ + 1) % array.size();
       ++count_;
     }
 
@@ -332,7 +803,7 @@ class CQueue
       front_ = (front_ + 1) % array.size();
       --count_;
 
-      return array[currentFront];
+      return std::move(array.data()[currentFront]);
     }
 
 
@@ -341,6 +812,7 @@ class CQueue
       array.clear();
       front_ = 0;
       back_ = 0;
+      count_ = 0;
     }
 
   private:
@@ -351,16 +823,22 @@ class CQueue
     void resize()
     {
       size_t size = array.size();
-      CArray<T> newArray((size == 0) ? 1 : size * 2);
+      resize((size == 0) ? 1 : size * 2);
+    }
+
+    void resize(const size_t &newSize)
+    {
+      size_t size = array.size();
+      CArray<T> newArray(newSize);
 
       for(size_t i = 0; i < count_; ++i)
       {
-        newArray[i] = array[(front_ + i) % size];
+        newArray.data()[i] = std::move(array.data()[(front_ + i) % size]);
       }
 
-      array = newArray;
+      array = std::move(newArray);
       front_ = 0;
-      back_ = count_;
+      back_ = count_ % newSize;
     }
 
     size_t front_ = 0, back_ = 0, count_ = 0;
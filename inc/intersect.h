@@ -0,0 +1,184 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   intersect.h
+ *
+ *  \brief
+ *    Interface of the vectorized ray and edge intersection kernels
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "arms_math.h"
+
+/*!
+ *  \struct EdgeSpan
+ *
+ *  \brief
+ *    A run of edges stored as structure of arrays
+ */
+struct EdgeSpan
+{
+  const float *beginX;
+  const float *beginY;
+  const float *endX;
+  const float *endY;
+  // The edge table index of each edge, if nullptr the edges are contiguous
+  // starting from firstEdge
+  const uint32_t *edgeIds;
+  uint32_t firstEdge;
+  size_t count;
+};
+
+/*!
+ *  \struct EdgeHit
+ *
+ *  \brief
+ *    The closest hit found by an intersection kernel. Hits are ordered by
+ *    distance and then by edge index.
+ */
+struct EdgeHit
+{
+  uint32_t edge = 0xFFFFFFFFu;
+  float distance = 0.f;
+  // The normalized point of intersection along the ray
+  float u = 0.f;
+
+  bool is_hit() const
+  {
+    return edge != 0xFFFFFFFFu;
+  }
+};
+
+/*!
+ *  \struct RayPacket
+ *
+ *  \brief
+ *    A group of rays traced together, stored as structure of arrays so the
+ *    packet kernels can test several rays against one edge at once. Lanes
+ *    past count are zeroed padding.
+ */
+struct RayPacket
+{
+  static inline const size_t MAX_SIZE = 16;
+  // Fewer rays than this are faster to trace one at a time
+  static inline const size_t MIN_SIZE = 4;
+
+  RayPacket()
+  {
+    clear();
+  }
+
+  void clear()
+  {
+    for(size_t i = 0; i < MAX_SIZE; ++i)
+    {
+      beginX[i] = beginY[i] = directionX[i] = directionY[i] = 0.f;
+      ignoreEdge[i] = 0xFFFFFFFFu;
+    }
+    count = 0;
+  }
+
+  /*!
+   *  Adds a ray to the packet, the packet must not already be full
+   *
+   *  \returns
+   *    The lane of the ray
+   */
+  size_t add(const Vec2 &rayBegin, const Vec2 &rayEnd
+      , const uint32_t &_ignoreEdge)
+  {
+    beginX[count] = rayBegin.x;
+    beginY[count] = rayBegin.y;
+    directionX[count] = rayEnd.x - rayBegin.x;
+    directionY[count] = rayEnd.y - rayBegin.y;
+    ignoreEdge[count] = _ignoreEdge;
+    return count++;
+  }
+
+  alignas(32) float beginX[MAX_SIZE];
+  alignas(32) float beginY[MAX_SIZE];
+  // The ray end minus the ray begin
+  alignas(32) float directionX[MAX_SIZE];
+  alignas(32) float directionY[MAX_SIZE];
+  alignas(32) uint32_t ignoreEdge[MAX_SIZE];
+  size_t count;
+};
+
+/*!
+ *  \struct PacketHits
+ *
+ *  \brief
+ *    The closest hit of each lane of a RayPacket
+ */
+struct PacketHits
+{
+  PacketHits()
+  {
+    clear();
+  }
+
+  void clear()
+  {
+    for(size_t i = 0; i < RayPacket::MAX_SIZE; ++i)
+    {
+      edge[i] = 0xFFFFFFFFu;
+      distance[i] = u[i] = 0.f;
+    }
+  }
+
+  EdgeHit get(const size_t &lane) const
+  {
+    EdgeHit hit;
+    hit.edge = edge[lane];
+    hit.distance = distance[lane];
+    hit.u = u[lane];
+    return hit;
+  }
+
+  alignas(32) uint32_t edge[RayPacket::MAX_SIZE];
+  alignas(32) float distance[RayPacket::MAX_SIZE];
+  alignas(32) float u[RayPacket::MAX_SIZE];
+};
+
+/*!
+ *  Tests a ray against every edge of a span, keeping the closest hit. Hits at
+ *  the start of the ray and on the ignored edge are skipped.
+ *
+ *  The AVX2 (8 edges) or SSE (4 edges) kernel is picked at runtime based on
+ *  get_simd_level(), each giving the exact same result as the scalar kernel.
+ *
+ *  \param span
+ *    The edges being tested
+ *  \param rayBegin
+ *    The position the ray starts at
+ *  \param rayEnd
+ *    The position the ray ends at
+ *  \param ignoreEdge
+ *    The edge the ray reflected off of
+ *  \param closest
+ *    The closest hit so far, updated if a closer hit is found
+ */
+void intersect_edges(const EdgeSpan &span, const Vec2 &rayBegin
+    , const Vec2 &rayEnd, const uint32_t &ignoreEdge, EdgeHit &closest);
+
+/*!
+ *  Tests the rays of a packet against every edge of a span, keeping the
+ *  closest hit of each ray. Each edge is loaded once and tested against 8
+ *  (AVX2) or 4 (SSE) rays at a time, giving the exact same hits as calling
+ *  intersect_edges for each ray.
+ *
+ *  \param span
+ *    The edges being tested
+ *  \param packet
+ *    The rays being tested
+ *  \param laneMask
+ *    Bit i set if lane i of the packet should be tested
+ *  \param hits
+ *    The closest hit of each lane so far, updated if a closer hit is found
+ */
+void intersect_ray_packet(const EdgeSpan &span, const RayPacket &packet
+    , const uint32_t &laneMask, PacketHits &hits);
@@ -31,13 +31,21 @@ class Listener : public Object
       , P_COUNT
     };
 
+    enum RECEIVER_MODE
+    {
+      R_BOX = 0
+      // Rays pass through a circle around the listener instead of hitting
+      // its box, see VolumeReceiver
+      , R_VOLUME
+    };
+
     inline static const float PolarCoefficents[P_COUNT] =
     {
       0.f, 0.25f, 0.37f, 0.5f, 0.7f, 1.f
     };
 
     Listener(const Vec2 &pos, const Vec2 &size, const float &direction
-        , const std::string &pattern);
+        , const std::string &pattern, const std::string &receiver = "box");
     ~Listener();
 
     /*!
@@ -49,10 +57,13 @@ class Listener : public Object
      */
     float get_directional_gain(Vec2 ray);
 
+    RECEIVER_MODE get_receiver_mode() const;
+
   private:
     inline static const sf::Color listenerColor = sf::Color::Red;
 
     Vec2 directionVec;
     POLAR_PATTERNS polarPattern = P_COUNT;
+    RECEIVER_MODE receiverMode = R_BOX;
 };
 
@@ -0,0 +1,113 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   preview.h
+ *
+ *  \brief
+ *    Interface of the live preview of a scene
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <SFML/Audio/SoundStream.hpp>
+
+#include "audiobuffer.h"
+#include "convolution.h"
+#include "helper.h"
+#include "ringbuffer.h"
+
+/*!
+ *  \class PreviewStream
+ *
+ *  \brief
+ *    Plays a wave convolved with the impulse response of a scene as it is
+ *    computed, so a scene can be heard without rendering it to a file.
+ *
+ *    A producer thread convolves the wave a block at a time and pushes the
+ *    result into a ring buffer that SFML's audio thread pops from. The audio
+ *    thread never locks or convolves, if the producer falls behind silence is
+ *    played and counted as an underrun.
+ *
+ *    The producer is kept at most RING_SIZE samples ahead of playback so the
+ *    convolver's background thread, which convolves the tail of the
+ *    response, is paced by playback. The producer only convolves the head.
+ *    The response is copied when the preview is loaded, so edits to the
+ *    scene are heard once the preview is started again.
+ */
+class PreviewStream : public sf::SoundStream
+{
+  public:
+    // The number of samples handed to SFML at a time, 23ms at 44100Hz
+    static inline const size_t CHUNK_SIZE = 1024;
+    // How far the producer may run ahead of playback, 46ms at 44100Hz. Once
+    // a chunk is handed over another is still waiting, so the producer can
+    // be held up by a whole scheduler tick without an underrun.
+    static inline const size_t RING_SIZE = 2 * CHUNK_SIZE;
+
+    PreviewStream();
+    ~PreviewStream();
+
+    /*!
+     *  Stops any playback and loads a new wave and response to play
+     *
+     *  \param _samples
+     *    The samples of the wave
+     *  \param samplingRate
+     *    The sampling rate of the wave
+     *  \param _response
+     *    The impulse response the wave is convolved with, at the same
+     *    sampling rate
+     */
+    void load(const AudioBuffer &_samples, const unsigned &samplingRate
+        , const AudioBuffer &_response);
+    /*!
+     *  Stops playback along with the producer and the convolver's background
+     *  thread, nothing is left running until the next load
+     */
+    void stop_preview();
+
+    bool is_playing() const;
+    /*!
+     *  \returns
+     *    The number of chunks that had to be padded with silence because the
+     *    producer fell behind
+     */
+    size_t get_underruns() const;
+
+  protected:
+    bool onGetData(Chunk &data) override;
+    void onSeek(sf::Time timeOffset) override;
+
+  private:
+    /*!
+     *  Starts convolving from a given sample, the producer must be stopped
+     *
+     *  \param position
+     *    The sample of the wave to start from
+     */
+    void start_producer(const size_t &position);
+    void stop_producer();
+    void run_producer();
+
+    AudioBuffer samples;
+    AudioBuffer response;
+    unsigned currentSamplingRate = 0;
+
+    // Only used by the producer once it is started
+    NonUniformConvolver convolver;
+    size_t producerPosition = 0;
+
+    RingBuffer<int16_t> ring;
+    std::vector<int16_t> chunk;
+
+    std::thread producer;
+    std::atomic<bool> producing{false};
+    std::atomic<bool> finished{false};
+    std::atomic<size_t> underruns{0};
+};
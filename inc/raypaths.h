@@ -0,0 +1,119 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   raypaths.h
+ *
+ *  \brief
+ *    Interface of the flat storage of traced ray paths
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "arms_math.h"
+#include "bandgrid.h"
+
+/*!
+ *  \class RayPaths
+ *
+ *  \brief
+ *    Every path traced from the source to the listener stored in a few flat
+ *    arrays rather than an object per bounce.
+ *
+ *    The reflection points of all paths are contiguous with path i owning the
+ *    points from pathOffsets[i] up to pathOffsets[i + 1]. As a path always has
+ *    one less segment than points, the segments of path i start at
+ *    pathOffsets[i] - i in the segment arrays. Every path stores the energy
+ *    of each band of the scene's BandGrid that reached the listener.
+ *
+ *    Nothing here depends on SFML, the scene builds vertices from the paths
+ *    only when they are drawn.
+ */
+class RayPaths
+{
+  public:
+    enum PATH_HIGHLIGHT
+    {
+      PH_NONE = 0
+      , PH_LOUDEST
+      , PH_SHORTEST
+      , PH_LOUDEST_SHORTEST
+    };
+
+    RayPaths();
+    ~RayPaths();
+
+    /*!
+     *  Removes every path and sets the number of bands stored for each path
+     */
+    void clear(const size_t &_bandCount = 0);
+    /*!
+     *  Reserves space so adding paths doesn't reallocate
+     *
+     *  \param pathCount
+     *    The number of paths expected
+     *  \param pointCount
+     *    The total number of reflection points expected
+     */
+    void reserve(const size_t &pathCount, const size_t &pointCount);
+
+    /*!
+     *  Adds a traced path
+     *
+     *  \param points
+     *    The points of the path, starting at the source
+     *  \param levels
+     *    The average energy of each segment, one less than the points
+     *  \param pointCount
+     *    The number of points of the path, at least 2
+     *  \param energy
+     *    The energy of each band that reached the listener
+     */
+    void add_path(const Vec2 *points, const float *levels
+        , const size_t &pointCount, const BandEnergy &energy);
+    /*!
+     *  Adds every path of another set of paths after the existing paths,
+     *  both must store the same number of bands
+     */
+    void append(const RayPaths &other);
+
+    size_t size() const;
+    bool empty() const;
+    size_t get_point_total() const;
+    size_t get_band_count() const;
+
+    size_t get_point_count(const size_t &path) const;
+    size_t get_segment_count(const size_t &path) const;
+    const Vec2 *get_points(const size_t &path) const;
+    /*!
+     *  \returns
+     *    The length of a segment within the scene
+     */
+    float get_segment_length(const size_t &path, const size_t &segment) const;
+    float get_segment_level(const size_t &path, const size_t &segment) const;
+
+    /*!
+     *  \returns
+     *    The energy of each band of a path, get_band_count() long
+     */
+    const float *get_bands(const size_t &path) const;
+    /*!
+     *  \returns
+     *    The average energy that reached the listener or 1 with no bands
+     */
+    float get_energy_average(const size_t &path) const;
+
+    PATH_HIGHLIGHT get_highlight(const size_t &path) const;
+    void set_highlight(const size_t &path, const PATH_HIGHLIGHT &highlight);
+
+  private:
+    std::vector<Vec2> points;
+    std::vector<uint32_t> pathOffsets;
+    std::vector<float> segmentLevels;
+    std::vector<float> bands;
+    size_t bandCount = 0;
+    std::vector<uint8_t> highlights;
+};
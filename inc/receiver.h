@@ -0,0 +1,139 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   receiver.h
+ *
+ *  \brief
+ *    Interface of volumetric receivers and the energy histograms they record
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "arms_math.h"
+#include "audiobuffer.h"
+#include "bandgrid.h"
+#include "helper.h"
+
+class Listener;
+
+/*!
+ *  \class EnergyHistogram
+ *
+ *  \brief
+ *    The energy of each band that reached a receiver, summed into fixed time
+ *    bins. Its memory only depends on the length of the response rather than
+ *    the number of rays traced, the bins grow as later energy arrives.
+ */
+class EnergyHistogram
+{
+  public:
+    // The default width of a bin in seconds
+    static inline const float DEFAULT_BIN_WIDTH = 0.001f;
+
+    EnergyHistogram();
+    ~EnergyHistogram();
+
+    /*!
+     *  Removes every bin
+     *
+     *  \param _bandCount
+     *    The number of bands of the scene's BandGrid
+     *  \param _binWidth
+     *    The width of each bin in seconds
+     */
+    void clear(const size_t &_bandCount = 0
+        , const float &_binWidth = DEFAULT_BIN_WIDTH);
+
+    /*!
+     *  Adds energy arriving at a given time
+     *
+     *  \param time
+     *    The time of arrival in seconds
+     *  \param energy
+     *    The energy of each band
+     *  \param scale
+     *    Scales the energy before it is added
+     */
+    void add(const float &time, const BandEnergy &energy, const float &scale);
+    /*!
+     *  Sums the bins of another histogram into this one, both must have the
+     *  same bin width
+     */
+    void merge(const EnergyHistogram &other);
+
+    size_t size() const;
+    bool empty() const;
+    size_t get_band_count() const;
+    float get_bin_width() const;
+    const BandEnergy &get_bin(const size_t &bin) const;
+
+    /*!
+     *  Synthesises an impulse response from the histogram. Every band shapes
+     *  the same noise by the square root of its energy in each bin and is
+     *  then band passed around its frequency, so the response has the time
+     *  and frequency envelope of the histogram with the fine structure of
+     *  noise. The response ends once the energy of every later bin is 60dB
+     *  below the loudest bin.
+     *
+     *  \param grid
+     *    The bands the histogram was recorded in
+     *  \param samplingRate
+     *    The sampling rate of the response
+     *
+     *  \returns
+     *    The samples of the impulse response
+     */
+    AudioBuffer synthesise_impulse_response(const BandGrid &grid
+        , const unsigned &samplingRate) const;
+
+  private:
+    std::vector<BandEnergy> bins;
+    size_t bandCount = 0;
+    float binWidth = DEFAULT_BIN_WIDTH;
+};
+
+/*!
+ *  \struct VolumeReceiver
+ *
+ *  \brief
+ *    A listener treated as a detection circle rays pass through rather than
+ *    collide with. Every time a ray passes through the circle it adds its
+ *    energy, weighted by the length of the ray within the circle over its
+ *    area, to a histogram at the time it reached the circle. This estimates
+ *    the energy density at the listener from every ray that passes nearby
+ *    instead of only those that hit it.
+ */
+struct VolumeReceiver
+{
+  /*!
+   *  Adds a segment of a ray that may pass through the receiver
+   *
+   *  \param begin
+   *    The start of the segment within the scene
+   *  \param end
+   *    The end of the segment within the scene
+   *  \param distance
+   *    The distance, in centimeters, the ray travelled before the segment
+   *  \param energy
+   *    The energy of the ray along the segment
+   *  \param histogram
+   *    The histogram the energy is added to
+   *
+   *  \returns
+   *    The length of the segment in centimeters
+   */
+  float add_segment(const Vec2 &begin, const Vec2 &end, const float &distance
+      , const BandEnergy &energy, EnergyHistogram &histogram) const;
+
+  Listener *listener = nullptr;
+  // The circle within the scene
+  Vec2 center;
+  float radius = 0.f;
+  // Scene units per centimeter
+  float scalar = 1.f;
+  // The share of the source's energy each inital ray carries
+  float rayEnergy = 1.f;
+};
@@ -0,0 +1,111 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   reverb.h
+ *
+ *  \brief
+ *    Interface of the feedback delay network used for artificial reverb
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "arms_math.h"
+#include "audiobuffer.h"
+#include "filter.h"
+#include "helper.h"
+
+/*!
+ *  \class FeedbackDelayNetwork
+ *
+ *  \brief
+ *    A reverb of parallel delay lines whose outputs are mixed by a Householder
+ *    matrix and fed back into every line, so each echo keeps spawning more
+ *    and the tail builds up the way a room does.
+ *
+ *    Each line ends in a cascade of shelves that absorbs as much of every
+ *    band as the room would over the length of the line, so every band
+ *    decays by 60 dB over its own T60 no matter which lines it passes
+ *    through. The delays are coprime so the echoes of the lines don't pile
+ *    up on the same samples.
+ *
+ *    Every line is at least as long as the blocks the lines are run in, so
+ *    the input is processed one line at a time over a whole block rather
+ *    than one sample at a time, costing O(samples x lines).
+ */
+class FeedbackDelayNetwork : public Filter
+{
+  public:
+    // Rooms with next to no absorption are cut off rather than ringing
+    // forever
+    static inline const float MAX_T60 = 20.f;
+
+    FeedbackDelayNetwork();
+    ~FeedbackDelayNetwork();
+
+    /*!
+     *  Builds the network, clearing any signal still in it
+     *
+     *  \param delays
+     *    The delay of each line in samples, one line is made per delay
+     *  \param t60s
+     *    The frequency of each band and the seconds it takes to decay by 60
+     *    dB
+     *  \param _samplingRate
+     *    The sampling rate of the signal
+     */
+    void set_network(const CArray<uint16_t> &delays, const CoefficentArray &t60s
+        , const float &_samplingRate);
+    size_t get_line_count() const;
+    /*!
+     *  \returns
+     *    The number of samples until an impulse has decayed by 60 dB in every
+     *    band
+     */
+    size_t get_tail_length() const;
+
+    /*!
+     *  Replaces the samples with their reverb, the output is longer than the
+     *  input by the tail length so the reverb can fully decay
+     */
+    void apply_filter(AudioBuffer &samples) override;
+    void reset() override;
+    void process_block(const float *input, float *output
+        , const size_t &count) override;
+
+  private:
+    // A high shelf biquad along with its state
+    struct SHELF
+    {
+      float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+      float x1 = 0.f, x2 = 0.f, y1 = 0.f, y2 = 0.f;
+    };
+
+    struct LINE
+    {
+      // A ring of the delay's length, head is read and then overwritten
+      std::vector<float> buffer;
+      size_t head = 0;
+      // The absorption of the lowest band
+      float gain = 1.f;
+      // The change in absorption into each band after the lowest
+      std::vector<SHELF> shelves;
+    };
+
+    /*!
+     *  Runs count samples of the network, count must not be longer than the
+     *  shortest line
+     */
+    void run_lines(const float *input, float *output, const size_t &count);
+
+    float samplingRate = 0.f;
+    size_t minDelay = 0;
+    size_t tailLength = 0;
+    std::vector<LINE> lines;
+    // The output of every line over a block, one line after another
+    std::vector<float> lineOutput;
+    std::vector<float> mix;
+};
@@ -0,0 +1,152 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   ringbuffer.h
+ *
+ *  \brief
+ *    A lock-free ring buffer for passing samples between two threads
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*!
+ *  \class RingBuffer
+ *
+ *  \brief
+ *    A single-producer single-consumer ring buffer. One thread may push while
+ *    another pops without either locking or waiting on the other, so it is
+ *    safe to pop from an audio callback.
+ *
+ *    The read and write positions only ever increase and are masked into the
+ *    buffer, so the capacity is always a power of two and a full buffer can
+ *    be told apart from an empty one.
+ */
+template <typename T>
+class RingBuffer
+{
+  public:
+    RingBuffer(const size_t &_capacity = 0)
+    {
+      resize(_capacity);
+    }
+
+    /*!
+     *  Resizes the buffer, dropping anything in it. Neither thread may be
+     *  using the buffer.
+     *
+     *  \param _capacity
+     *    The smallest number of values the buffer holds, rounded up to a
+     *    power of two
+     */
+    void resize(const size_t &_capacity)
+    {
+      size_t size = 1;
+      while(size < _capacity)
+      {
+        size <<= 1;
+      }
+
+      buffer.assign(size, T());
+      mask = size - 1;
+      clear();
+    }
+
+    /*!
+     *  Drops anything in the buffer. Neither thread may be using the buffer.
+     */
+    void clear()
+    {
+      readIndex.store(0, std::memory_order_relaxed);
+      writeIndex.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+      return buffer.size();
+    }
+
+    /*!
+     *  \returns
+     *    The number of values that can be popped
+     */
+    size_t get_available() const
+    {
+      return writeIndex.load(std::memory_order_acquire)
+        - readIndex.load(std::memory_order_acquire);
+    }
+
+    /*!
+     *  \returns
+     *    The number of values that can be pushed
+     */
+    size_t get_free() const
+    {
+      return buffer.size() - get_available();
+    }
+
+    /*!
+     *  Pushes as many values as fit, only called by the producer
+     *
+     *  \param values
+     *    The values being pushed
+     *  \param count
+     *    The number of values
+     *
+     *  \returns
+     *    The number of values pushed
+     */
+    size_t push(const T *values, const size_t &count)
+    {
+      const size_t write = writeIndex.load(std::memory_order_relaxed);
+      const size_t read = readIndex.load(std::memory_order_acquire);
+      const size_t pushed = std::min(count, buffer.size() - (write - read));
+
+      for(size_t i = 0; i < pushed; ++i)
+      {
+        buffer[(write + i) & mask] = values[i];
+      }
+
+      // Publish the values only once they are written
+      writeIndex.store(write + pushed, std::memory_order_release);
+      return pushed;
+    }
+
+    /*!
+     *  Pops as many values as are available, only called by the consumer
+     *
+     *  \param values
+     *    Where the popped values are written
+     *  \param count
+     *    The most values to pop
+     *
+     *  \returns
+     *    The number of values popped
+     */
+    size_t pop(T *values, const size_t &count)
+    {
+      const size_t read = readIndex.load(std::memory_order_relaxed);
+      const size_t write = writeIndex.load(std::memory_order_acquire);
+      const size_t popped = std::min(count, write - read);
+
+      for(size_t i = 0; i < popped; ++i)
+      {
+        values[i] = buffer[(read + i) & mask];
+      }
+
+      // Only hand the space back once the values are read
+      readIndex.store(read + popped, std::memory_order_release);
+      return popped;
+    }
+
+  private:
+    std::vector<T> buffer;
+    size_t mask = 0;
+    // Kept on separate cache lines so the threads don't contend over them
+    alignas(64) std::atomic<size_t> readIndex{0};
+    alignas(64) std::atomic<size_t> writeIndex{0};
+};
@@ -12,25 +12,44 @@
 #include <vector>
 #include <string>
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Vertex.hpp>
 
 #include "arms_math.h"
+#include "audiobuffer.h"
+#include "bandgrid.h"
+#include "collisiongrid.h"
+#include "edgetable.h"
 #include "filter.h"
+#include "generator.h"
 #include "helper.h"
+#include "raypaths.h"
+#include "receiver.h"
 
-typedef class AudioRay AudioRay;
 typedef class Object Object;
 typedef class Filter Filter;
 typedef class WaveFile WaveFile;
-typedef struct RayGenerationInfo RayGenerationInfo;
+typedef class WaveReader WaveReader;
+typedef class WaveWriter WaveWriter;
 typedef struct Vec2 Vec;
-typedef struct SAMPLES SAMPLES;
 
-using AudioRayVec = std::vector<std::vector<AudioRay *>>;
 using ObjectVec = std::vector<Object *>;
 
 class Scene
 {
   public:
+    // The number of samples streamed through the filters at a time, a
+    // multiple of every Convolver block size
+    static inline const size_t STREAM_BLOCK_SIZE = 4096;
+
+    enum RENDER_MODE
+    {
+      // Convolves the input with one impulse response built from every path
+      RM_CONVOLUTION = 0
+      // Splits the input into bands once and mixes every path from them,
+      // kept as a reference for the convolution
+      , RM_PER_PATH
+    };
+
     Scene(const Vec2 &topLeftPos, const Vec2 &size, const Vec2 &scalar);
     Scene(const std::string &fileName, const Vec2 &topLeftPos
         , const Vec2 &size, const Vec2 &scalar
@@ -53,40 +72,104 @@ class Scene
 
     bool is_open() const;
 
+    /*!
+     *  Sets how the rays of the scene are traced, taking effect the next time
+     *  a scene is opened
+     *
+     *  \param info
+     *    The new ray generation settings
+     */
+    void set_ray_generation_info(const RayGenerationInfo &info);
+    const RayGenerationInfo &get_ray_generation_info() const;
+
+    /*!
+     *  Sets how apply_filter_to_wave renders the paths of the scene. A
+     *  volumetric listener is always convolved.
+     */
+    void set_render_mode(const RENDER_MODE &mode);
+    const RENDER_MODE &get_render_mode() const;
+
     void apply_filter_to_wave(WaveFile &wave);
+    /*!
+     *  Renders the paths of the scene from one .wav file into another a
+     *  block at a time, so only a block of audio is in memory no matter how
+     *  long the file is. The output is the same as apply_filter_to_wave.
+     *
+     *  \param input
+     *    An open reader of the input
+     *  \param output
+     *    An open writer the output is written to, closing it is left to the
+     *    caller
+     */
+    void render_wave_file(WaveReader &input, WaveWriter &output);
+    /*!
+     *  Gets the impulse response the scene is convolved with, the same one
+     *  apply_filter_to_wave uses when convolving so live playback sounds the
+     *  same as a render
+     *
+     *  \param samplingRate
+     *    The sampling rate of the audio the response is used with
+     *
+     *  \returns
+     *    The impulse response of the whole scene
+     */
+    const AudioBuffer &get_impulse_response(const unsigned &samplingRate);
     void apply_t60_to_wave(WaveFile &wave);
 
     std::string get_name() const;
     
     void draw(sf::RenderWindow &window);
   private:
+    void generate_scene_filter();
     /*!
-     *  Adds a bandpass reverb filter based on user given delay to 
-     *  a given input.
-     *  Instead of overwriting the input it adds it to a given output.
+     *  Builds the filters of the current render mode for a sampling rate if
+     *  they aren't already
      *
+     *  \returns
+     *    If the scene is convolved rather than rendered per path
+     */
+    bool prepare_scene_filter(const unsigned &samplingRate);
+    /*!
+     *  Gets the length of a render, long enough for every path to arrive and
+     *  ring out by 60 dB after the input ends
      *
-     *  \param delay
-     *    The delay for the comb filter
-     *  \param frequency
-     *    The frequency of the bandpass filter
-     *  \param bandCount
-     *    The number of bands in the bandpass filter
-     *  \param coefficent
-     *    The T60-based absorbtion coefficent
-     *  \param outputScale
-     *    Scales the output by a given value (used to ensure the output
-     *    doesn't clip)
-     *  \param input
-     *    A copy of the input sample data
-     *  \param output
-     *    A reference to the output data that will be mixed together
+     *  \param inputLength
+     *    The number of samples of input
+     *  \param convolve
+     *    If the scene is convolved rather than rendered per path
+     *
+     *  \returns
+     *    The number of samples of output
      */
-    void add_bandpass_reverb_filter(const uint16_t &delay
-        , const float &frequency, const size_t &bandCount
-        , const float &coefficent, const float &outputScale
-        , const CArray<float> &input, CArray<float> &output);
-    void generate_scene_filter();
+    size_t get_render_length(const size_t &inputLength
+        , const bool &convolve) const;
+    /*!
+     *  \returns
+     *    The delay of a path in samples at the current sampling rate
+     */
+    unsigned get_path_delay(const size_t &path) const;
+    /*!
+     *  Builds the impulse response of every path at once. Each band gets a
+     *  train of impulses at the delay of each path, scaled by the path's
+     *  energy in the band, which is then band passed the same as the
+     *  FilterBank's band. As the filters are linear convolving with the sum
+     *  of the bands matches rendering each path.
+     *
+     *  \returns
+     *    The impulse response of the paths at the current sampling rate
+     */
+    AudioBuffer build_path_impulse_response() const;
+    /*!
+     *  \returns
+     *    The impulse response of the scene, synthesised from the histogram of
+     *    a volumetric listener or built from the paths otherwise
+     */
+    AudioBuffer build_impulse_response() const;
+    /*!
+     *  Builds the line vertices of every traced path, coloured by the energy
+     *  of each segment
+     */
+    void build_ray_vertices();
     void clear();
 
     bool open = false;
@@ -98,8 +181,21 @@ class Scene
 
     std::string name;
 
-    CArray<Equalizer> filters;
-    AudioRayVec audioRayVec;
+    RayGenerationInfo rayGenerationInfo;
+    RENDER_MODE renderMode = RM_CONVOLUTION;
+    BandGrid bandGrid;
+    EdgeTable edgeTable;
+    CollisionGrid collisionGrid;
+
+    // The band split and path taps when rendering each path
+    FilterBank filterBank;
+    RayPaths rayPaths;
+    // Only used when the listener is a volumetric receiver
+    EnergyHistogram histogram;
+    // The impulse response of the scene when it is convolved
+    Convolver convolver;
+    // Only built once the scene is drawn
+    std::vector<sf::Vertex> rayVertices;
     ObjectVec objects;
 };
 
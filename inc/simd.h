@@ -0,0 +1,61 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   simd.h
+ *
+ *  \brief
+ *    Runtime detection of the SIMD instruction sets kernels can use
+ */
+
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) \
+  || defined(_M_IX86)
+  #define ARMS_X86 1
+  #include <immintrin.h>
+#else
+  #define ARMS_X86 0
+#endif
+
+// SSE2 is part of every x86-64 CPU so it can be used without a runtime check
+#if ARMS_X86 && (defined(__SSE2__) || defined(_M_X64) \
+  || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #define ARMS_SSE2 1
+#else
+  #define ARMS_SSE2 0
+#endif
+
+// Functions using AVX2 intrinsics must be marked so GCC and Clang will
+// compile them without the whole program requiring AVX2. MSVC allows the
+// intrinsics anywhere. FMA is deliberately not enabled so the compiler can't
+// fuse multiplies and adds, keeping results identical to the scalar kernels.
+#if ARMS_X86 && (defined(__GNUC__) || defined(__clang__))
+  #define ARMS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define ARMS_TARGET_AVX2
+#endif
+
+enum SIMD_LEVEL
+{
+  SL_SCALAR = 0
+  , SL_SSE
+  , SL_AVX2
+};
+
+/*!
+ *  Gets the best instruction set supported by both the CPU and the build,
+ *  limited by any call to limit_simd_level
+ *
+ *  \returns
+ *    The SIMD level kernels should use
+ */
+SIMD_LEVEL get_simd_level();
+
+/*!
+ *  Limits the SIMD level kernels will use, i.e. to compare against the
+ *  scalar kernels. Levels above what is supported are ignored.
+ *
+ *  \param level
+ *    The highest SIMD level allowed
+ */
+void limit_simd_level(const SIMD_LEVEL &level);
@@ -21,13 +21,27 @@ class Source : public Object
 {
   public:
     Source(const Vec2 &pos, const Vec2 &size, const float &direction
-        , const float &cone, const int &checks, const int &rays);
+        , const float &cone, const int &checks, const int &rays
+        , const float &threshold = 0.f, const bool &roulette = false);
     ~Source();
     
     const float &get_direction();
     const float &get_cone();
     const int &get_checks();
     const int &get_rays();
+    /*!
+     *  \returns
+     *    The energy floor in dB, relative to the energy a ray starts with, a
+     *    ray stops bouncing below. 0 disables the floor so rays only stop
+     *    after their checks.
+     */
+    const float &get_threshold();
+    /*!
+     *  \returns
+     *    If rays below the threshold survive by Russian roulette rather than
+     *    always being stopped
+     */
+    const bool &get_roulette();
 
   private:
     inline static const sf::Color sourceColor = sf::Color::Blue;
@@ -36,4 +50,6 @@ class Source : public Object
     float cone;
     int checks;
     int rays;
+    float threshold;
+    bool roulette;
 };
@@ -0,0 +1,121 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   taps.h
+ *
+ *  \brief
+ *    Interface of the sparse multi-tap delay used to mix delayed copies of a
+ *    signal
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "convolution.h"
+
+/*!
+ *  \class MultiTapDelay
+ *
+ *  \brief
+ *    Adds delayed and scaled copies of an input into an output, i.e. the
+ *    paths of a scene or a pattern of early reflections. Taps are sorted by
+ *    delay and taps on the same delay merged, then each tap is a single
+ *    vectorized y[n + delay] += gain * x[n] over the whole run of samples it
+ *    reaches with no per-sample checks.
+ *
+ *    Once there are enough taps that every sample costs more than a
+ *    partitioned FFT convolution would, the taps are turned into an impulse
+ *    response and convolved by a UniformConvolver instead.
+ *
+ *    prepare has to be called once the taps are added and before they are
+ *    mixed. Mixing drives the convolver, so a MultiTapDelay is only ever
+ *    used by one thread at a time.
+ */
+class MultiTapDelay
+{
+  public:
+    // The largest block a dense set of taps is convolved in
+    static inline const size_t MAX_BLOCK_SIZE = 4096;
+
+    MultiTapDelay();
+    ~MultiTapDelay();
+
+    void add_tap(const unsigned &delay, const float &gain);
+    void clear();
+    /*!
+     *  Sorts and merges the taps then decides how they are mixed. Only does
+     *  anything when taps were added since it was last called.
+     */
+    void prepare();
+    bool is_prepared() const;
+
+    /*!
+     *  \returns
+     *    The number of taps, taps on the same delay are merged once prepared
+     */
+    size_t size() const;
+    unsigned get_max_delay() const;
+    /*!
+     *  \returns
+     *    If the prepared taps are convolved by FFT rather than mixed one by
+     *    one
+     */
+    bool is_dense() const;
+
+    /*!
+     *  Adds every tap of the input into the output, output[n + delay] +=
+     *  gain * input[n]. Anything that would land past the output is dropped.
+     *  The taps must be prepared.
+     *
+     *  \param input
+     *    The samples being delayed
+     *  \param inputSize
+     *    The number of samples of input
+     *  \param output
+     *    The samples the taps are added into
+     *  \param outputSize
+     *    The number of samples of output
+     */
+    void accumulate(const float *input, const size_t &inputSize
+        , float *output, const size_t &outputSize);
+    /*!
+     *  Adds every tap of the input into a ring of output, the same as
+     *  accumulate but wrapping past the end of the ring rather than dropping
+     *  what lands there
+     *
+     *  \param input
+     *    The samples being delayed
+     *  \param inputSize
+     *    The number of samples of input
+     *  \param ring
+     *    The ring the taps are added into, a power of two long and at least
+     *    inputSize + get_max_delay() samples
+     *  \param ringSize
+     *    The number of samples in the ring
+     *  \param start
+     *    Where in the ring the first sample of input lands with no delay
+     */
+    void accumulate_ring(const float *input, const size_t &inputSize
+        , float *ring, const size_t &ringSize, const size_t &start);
+
+  private:
+    struct TAP
+    {
+      unsigned delay = 0u;
+      float gain = 0.f;
+    };
+
+    void accumulate_sparse(const float *input, const size_t &inputSize
+        , float *output, const size_t &outputSize) const;
+    void accumulate_dense(const float *input, const size_t &inputSize
+        , float *output, const size_t &outputSize);
+
+    std::vector<TAP> taps;
+    bool prepared = true;
+    bool dense = false;
+    // Only holds the taps when they are dense
+    UniformConvolver engine;
+    unsigned maxDelay = 0u;
+};
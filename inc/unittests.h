@@ -9,10 +9,32 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
 #include "helper.h"
 
-#include "wave.h"
+#include "bandgrid.h"
+#include "collisiongrid.h"
+#include "convolution.h"
+#include "edgetable.h"
 #include "filter.h"
+#include "generator.h"
+#include "intersect.h"
+#include "object.h"
+#include "parsedata.h"
+#include "raypaths.h"
+#include "reverb.h"
+#include "scene.h"
+#include "simd.h"
+#include "taps.h"
+#include "wave.h"
 
 void test_wave_input_output(const std::string &fileName)
 {
@@ -30,3 +52,671 @@ void test_wave_with_simple_filter(const std::string &fileName)
 
   wave.output_to_file(fileName + "_out");
 }
+
+/*!
+ *  Writes samples in every supported .wav format at every SIMD level and
+ *  reads them back, checking every level writes the same values, samples
+ *  come back within a few steps of the format and samples outside of
+ *  [-1, 1] are clamped to full scale
+ *
+ *  \param fileName
+ *    The name of the file written within the output directory
+ *
+ *  \returns
+ *    If every format round trips
+ */
+bool test_wave_round_trip(const std::string &fileName = "round_trip")
+{
+  // A ramp over the full range then samples that have to be clamped, an odd
+  // count so the SIMD kernels also run their scalar tails
+  std::vector<float> samples, expected;
+  for(int i = -500; i <= 500; ++i)
+  {
+    samples.push_back(static_cast<float>(i) / 500.f);
+    expected.push_back(samples.back());
+  }
+  const float outside[] = {2.f, -2.f, 1.5f, -1.0001f, INFINITY, -INFINITY
+    , NAN};
+  const float clamped[] = {1.f, -1.f, 1.f, -1.f, 1.f, -1.f, -1.f};
+  for(size_t i = 0; i < 7; ++i)
+  {
+    samples.push_back(outside[i]);
+    expected.push_back(clamped[i]);
+  }
+
+  struct FORMAT
+  {
+    uint16_t audioFormat;
+    unsigned bitsPerSample;
+    // The largest difference allowed after a round trip
+    float tolerance;
+  };
+  const FORMAT formats[] = {
+    {WF_PCM, 8, 3.f / 128.f}
+    , {WF_PCM, 16, 3.f / 32768.f}
+    , {WF_PCM, 24, 3.f / 8388608.f}
+    // Decoded 32-bit values are rounded to the precision of a float
+    , {WF_PCM, 32, 1.2e-7f}
+    , {WF_IEEE_FLOAT, 32, 0.f}};
+
+  const std::string path = OUTPUT_DIR + fileName;
+  const SIMD_LEVEL supported = get_simd_level();
+  bool passed = true;
+  for(const FORMAT &format : formats)
+  {
+    WAVE_HEADER header;
+    header.audioFormat = format.audioFormat;
+    header.set_bitsPerSample(format.bitsPerSample);
+
+    std::vector<char> scalarValues;
+    float maxDifference = 0.f;
+    for(int level = SL_SCALAR; level <= SL_AVX2; ++level)
+    {
+      limit_simd_level(static_cast<SIMD_LEVEL>(level));
+
+      WaveWriter writer;
+      if(!writer.open(path, header))
+      {
+        passed = false;
+        break;
+      }
+      writer.write_block(samples.data(), samples.size());
+      writer.close();
+
+      // The values after the 44 byte header are compared across levels
+      std::ifstream file(path + ".wav", std::ios::in | std::ios::binary);
+      std::vector<char> values((std::istreambuf_iterator<char>(file))
+          , std::istreambuf_iterator<char>());
+      values.erase(values.begin(), values.begin()
+          + std::min<size_t>(44, values.size()));
+      if(level == SL_SCALAR)
+      {
+        scalarValues = values;
+      }
+      else if(values != scalarValues)
+      {
+        passed = false;
+      }
+
+      WaveReader reader;
+      std::vector<float> decoded(samples.size());
+      if(!reader.open(path + ".wav", true)
+          || reader.read_block(decoded.data(), decoded.size())
+            != decoded.size())
+      {
+        passed = false;
+        break;
+      }
+      for(size_t i = 0; i < decoded.size(); ++i)
+      {
+        maxDifference = std::max(maxDifference
+            , std::fabs(decoded[i] - expected[i]));
+      }
+
+      if(level >= supported)
+      {
+        break;
+      }
+    }
+
+    // Full scale 32-bit samples use the whole range of an int32
+    if(format.audioFormat == WF_PCM && format.bitsPerSample == 32
+        && scalarValues.size() == 4 * samples.size())
+    {
+      int32_t lowest = 0, half = 0, highest = 0;
+      memcpy(&lowest, scalarValues.data(), sizeof(int32_t));
+      memcpy(&half, scalarValues.data() + 4 * 750, sizeof(int32_t));
+      memcpy(&highest, scalarValues.data() + 4 * 1000, sizeof(int32_t));
+      passed = passed && lowest == -2147483647 && half == 1073741823
+        && highest == 2147483647;
+    }
+
+    passed = passed && maxDifference <= format.tolerance;
+    static_cast<void>(Logger(maxDifference <= format.tolerance
+          ? Logger::L_MSG : Logger::L_ERR
+          , std::to_string(format.bitsPerSample) + "-bit "
+          + (format.audioFormat == WF_PCM ? "pcm" : "float")
+          + " samples round tripped within "
+          + std::to_string(maxDifference)));
+  }
+  limit_simd_level(SL_AVX2);
+
+  return passed;
+}
+
+/*!
+ *  Traces a scene file within the input directory the same way a Scene
+ *  opening it would
+ *
+ *  \param fileName
+ *    The name of the scene file
+ *  \param info
+ *    How the rays are traced
+ *
+ *  \returns
+ *    The paths that hit the listener
+ */
+RayPaths trace_test_scene(const std::string &fileName
+    , const RayGenerationInfo &info)
+{
+  const Vec2 roomPos = {25.f, 25.f};
+  DataMap *dataMap = read_scene_file(fileName);
+  if(dataMap == nullptr)
+  {
+    return RayPaths();
+  }
+
+  Vec4 roomData = get_room_size(dataMap);
+  Vec2 roomSize = {roomData.x, roomData.y};
+  Vec2 scalar = {roomData.z, roomData.w};
+  std::vector<Object *> objects = convert_DataMap_to_Object(dataMap, roomPos
+      , scalar);
+
+  BandGrid bandGrid;
+  EdgeTable edgeTable;
+  CollisionGrid collisionGrid;
+  bandGrid.build(objects);
+  edgeTable.compile(objects, roomPos, roomSize, scalar, bandGrid);
+  if(info.useCollisionGrid)
+  {
+    collisionGrid.build(edgeTable);
+  }
+
+  RayPaths paths = generate_audio_rays_from_scene(objects, edgeTable, scalar
+      , info, &collisionGrid);
+
+  for(Object *object : objects)
+  {
+    delete object;
+  }
+  delete dataMap;
+
+  return paths;
+}
+
+/*!
+ *  \returns
+ *    If two sets of paths have exactly the same points, levels and band
+ *    energies
+ */
+bool compare_ray_paths(const RayPaths &a, const RayPaths &b)
+{
+  if(a.size() != b.size() || a.get_band_count() != b.get_band_count())
+  {
+    return false;
+  }
+
+  for(size_t path = 0; path < a.size(); ++path)
+  {
+    size_t pointCount = a.get_point_count(path);
+    if(pointCount != b.get_point_count(path)
+        || memcmp(a.get_points(path), b.get_points(path)
+          , pointCount * sizeof(Vec2)) != 0
+        || memcmp(a.get_bands(path), b.get_bands(path)
+          , a.get_band_count() * sizeof(float)) != 0)
+    {
+      return false;
+    }
+
+    for(size_t segment = 0; segment + 1 < pointCount; ++segment)
+    {
+      if(a.get_segment_level(path, segment)
+          != b.get_segment_level(path, segment))
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/*!
+ *  Traces a scene with a single worker and with several, checking the paths
+ *  are bitwise identical so golden files don't depend on the machine
+ *
+ *  \param fileName
+ *    The name of the scene file within the input directory
+ *  \param threadCount
+ *    The number of workers compared against a single worker
+ *
+ *  \returns
+ *    If the paths match
+ */
+bool test_trace_thread_count(const std::string &fileName
+    , const unsigned &threadCount = 8u)
+{
+  RayGenerationInfo info;
+  info.threadCount = 1u;
+  RayPaths serial = trace_test_scene(fileName, info);
+  info.threadCount = threadCount;
+  RayPaths parallel = trace_test_scene(fileName, info);
+
+  bool passed = compare_ray_paths(serial, parallel);
+  static_cast<void>(Logger(passed ? Logger::L_MSG : Logger::L_ERR
+        , "Tracing " + fileName + " with 1 and " + std::to_string(threadCount)
+        + " workers " + (passed ? "matched" : "DIFFERED") + " over "
+        + std::to_string(serial.size()) + " paths"));
+
+  return passed;
+}
+
+/*!
+ *  \returns
+ *    If two hits are bitwise identical
+ */
+bool compare_edge_hits(const EdgeHit &a, const EdgeHit &b)
+{
+  return a.edge == b.edge
+    && memcmp(&a.distance, &b.distance, sizeof(float)) == 0
+    && memcmp(&a.u, &b.u, sizeof(float)) == 0;
+}
+
+/*!
+ *  Runs the same random edges and rays through the intersection kernels of
+ *  every SIMD level, checking the SSE and AVX2 kernels and the packet kernels
+ *  give exactly the same hits as the scalar kernel. Points are snapped to a
+ *  coarse grid so rays start on edges, run along them and pass through their
+ *  ends, the cases the kernels are most likely to disagree on.
+ *
+ *  \param edgeCount
+ *    The number of edges, odd so every kernel has a remainder
+ *  \param rayCount
+ *    The number of rays, a multiple of RayPacket::MAX_SIZE
+ *
+ *  \returns
+ *    If every level matched
+ */
+bool test_intersect_simd_parity(const size_t &edgeCount = 301
+    , const size_t &rayCount = 512)
+{
+  uint32_t random = 0x9E3779B9u;
+  auto next_point = [&]()
+  {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return static_cast<float>(random % 64u) * 0.25f;
+  };
+
+  std::vector<float> beginX(edgeCount), beginY(edgeCount), endX(edgeCount)
+    , endY(edgeCount);
+  for(size_t i = 0; i < edgeCount; ++i)
+  {
+    beginX[i] = next_point();
+    beginY[i] = next_point();
+    endX[i] = next_point();
+    endY[i] = next_point();
+  }
+  // The first edges are read from a sub span with its own edge ids
+  std::vector<uint32_t> edgeIds(edgeCount);
+  for(size_t i = 0; i < edgeCount; ++i)
+  {
+    edgeIds[i] = static_cast<uint32_t>(edgeCount - 1 - i);
+  }
+  const EdgeSpan spans[2] = {
+    {beginX.data(), beginY.data(), endX.data(), endY.data(), nullptr, 0u
+      , edgeCount}
+    , {beginX.data(), beginY.data(), endX.data(), endY.data()
+      , edgeIds.data(), 0u, edgeCount}};
+
+  // Half of the rays start at the end of an edge
+  std::vector<Vec2> rayBegin(rayCount), rayEnd(rayCount);
+  std::vector<uint32_t> ignoreEdge(rayCount);
+  for(size_t i = 0; i < rayCount; ++i)
+  {
+    size_t edge = i % edgeCount;
+    rayBegin[i] = (i & 1) ? Vec2{endX[edge], endY[edge]}
+      : Vec2{next_point(), next_point()};
+    rayEnd[i] = Vec2{next_point(), next_point()};
+    ignoreEdge[i] = (i % 3 == 0) ? static_cast<uint32_t>(edge) : 0xFFFFFFFFu;
+  }
+
+  const SIMD_LEVEL supported = get_simd_level();
+  std::vector<EdgeHit> scalarHits(2 * rayCount);
+  bool passed = true;
+  size_t hitCount = 0;
+  for(int level = SL_SCALAR; level <= SL_AVX2; ++level)
+  {
+    limit_simd_level(static_cast<SIMD_LEVEL>(level));
+    for(size_t s = 0; s < 2; ++s)
+    {
+      for(size_t i = 0; i < rayCount; ++i)
+      {
+        EdgeHit hit;
+        intersect_edges(spans[s], rayBegin[i], rayEnd[i], ignoreEdge[i]
+            , hit);
+        if(level == SL_SCALAR)
+        {
+          scalarHits[s * rayCount + i] = hit;
+          hitCount += hit.is_hit();
+        }
+        else if(!compare_edge_hits(hit, scalarHits[s * rayCount + i]))
+        {
+          passed = false;
+        }
+      }
+
+      for(size_t first = 0; first < rayCount; first += RayPacket::MAX_SIZE)
+      {
+        RayPacket packet;
+        for(size_t i = first; i < first + RayPacket::MAX_SIZE; ++i)
+        {
+          packet.add(rayBegin[i], rayEnd[i], ignoreEdge[i]);
+        }
+
+        PacketHits hits;
+        intersect_ray_packet(spans[s], packet
+            , (1u << RayPacket::MAX_SIZE) - 1u, hits);
+        for(size_t lane = 0; lane < packet.count; ++lane)
+        {
+          if(!compare_edge_hits(hits.get(lane)
+                , scalarHits[s * rayCount + first + lane]))
+          {
+            passed = false;
+          }
+        }
+      }
+    }
+
+    if(level >= supported)
+    {
+      break;
+    }
+  }
+  limit_simd_level(SL_AVX2);
+
+  static_cast<void>(Logger(passed ? Logger::L_MSG : Logger::L_ERR
+        , "Intersection kernels up to SIMD level "
+        + std::to_string(supported) + (passed ? " matched" : " DIFFERED")
+        + " the scalar kernel over " + std::to_string(hitCount) + " hits"));
+
+  return passed;
+}
+
+/*!
+ *  Renders a wave through a scene both by convolving it with the scene's
+ *  impulse response and by rendering each path, checking the convolution
+ *  matches the reference
+ *
+ *  \param sceneName
+ *    The name of the scene file within the input directory
+ *  \param waveName
+ *    The name of the .wav file within the input directory
+ *  \param tolerance
+ *    The largest difference allowed between any two samples
+ *
+ *  \returns
+ *    If the renders match
+ */
+bool test_render_mode_parity(const std::string &sceneName
+    , const std::string &waveName, const float &tolerance = 1e-5f)
+{
+  Scene scene(sceneName, {25.f, 25.f}, {1000.f, 1000.f}, {1.f, 1.f});
+  WaveFile reference(waveName);
+  WaveFile convolved(reference);
+
+  scene.set_render_mode(Scene::RM_PER_PATH);
+  scene.apply_filter_to_wave(reference);
+  scene.set_render_mode(Scene::RM_CONVOLUTION);
+  scene.apply_filter_to_wave(convolved);
+
+  // Whichever render is longer must only add silence
+  const AudioBuffer &a = reference.get_samples();
+  const AudioBuffer &b = convolved.get_samples();
+  float maxDifference = 0.f;
+  for(size_t i = 0; i < std::max(a.size(), b.size()); ++i)
+  {
+    float x = (i < a.size()) ? a.at(i) : 0.f;
+    float y = (i < b.size()) ? b.at(i) : 0.f;
+    maxDifference = std::max(maxDifference, std::fabs(x - y));
+  }
+
+  bool passed = a.size() > 0 && maxDifference <= tolerance;
+  static_cast<void>(Logger(passed ? Logger::L_MSG : Logger::L_ERR
+        , "Convolving " + waveName + " through " + sceneName
+        + " differed from rendering each path by at most "
+        + std::to_string(maxDifference)));
+
+  return passed;
+}
+
+/*!
+ *  Mixes noise through random taps both few enough to be mixed one by one
+ *  and many enough to be convolved by FFT, checking both ways of mixing and
+ *  both the linear and ring output match summing every tap directly
+ *
+ *  \param inputSize
+ *    The number of samples of noise
+ *  \param maxDelay
+ *    The longest delay of any tap
+ *  \param tolerance
+ *    The largest difference allowed relative to the loudest sample
+ *
+ *  \returns
+ *    If every mix matched the direct sum
+ */
+bool test_tap_mixing(const size_t &inputSize = 5000
+    , const unsigned &maxDelay = 4000, const float &tolerance = 1e-5f)
+{
+  uint32_t state = 0x2545F491u;
+  auto next_random = [&state]()
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  };
+
+  std::vector<float> input(inputSize);
+  for(float &sample : input)
+  {
+    sample = static_cast<float>(next_random()) / 4294967296.f - 0.5f;
+  }
+
+  // Well below and well above the point the taps are convolved instead
+  const size_t tapCounts[] = {64, 2000};
+  const size_t outputSize = inputSize + maxDelay;
+  bool passed = true;
+  for(const size_t &tapCount : tapCounts)
+  {
+    MultiTapDelay taps;
+    std::vector<double> direct(outputSize, 0.0);
+    for(size_t i = 0; i < tapCount; ++i)
+    {
+      // The longest tap is always there so every count has the same length
+      unsigned delay = (i == 0) ? maxDelay : next_random() % maxDelay;
+      float gain = static_cast<float>(next_random()) / 4294967296.f - 0.5f;
+      taps.add_tap(delay, gain);
+      for(size_t n = 0; n < inputSize; ++n)
+      {
+        direct[n + delay] += static_cast<double>(gain) * input[n];
+      }
+    }
+    taps.prepare();
+
+    std::vector<float> output(outputSize, 0.f);
+    taps.accumulate(input.data(), inputSize, output.data(), outputSize);
+
+    // The ring starts part way in so the taps wrap around its end
+    const size_t ringSize = FFT::get_power_of_two(outputSize);
+    const size_t start = ringSize - inputSize / 2;
+    std::vector<float> ring(ringSize, 0.f);
+    taps.accumulate_ring(input.data(), inputSize, ring.data(), ringSize
+        , start);
+
+    double loudest = 0.0, outputDifference = 0.0, ringDifference = 0.0;
+    for(size_t n = 0; n < outputSize; ++n)
+    {
+      loudest = std::max(loudest, std::fabs(direct[n]));
+      outputDifference = std::max(outputDifference
+          , std::fabs(output[n] - direct[n]));
+      ringDifference = std::max(ringDifference
+          , std::fabs(ring[(start + n) & (ringSize - 1)] - direct[n]));
+    }
+    double relative = std::max(outputDifference, ringDifference)
+      / std::max(loudest, 1e-30);
+
+    bool matched = (taps.is_dense() == (tapCount > 1000))
+      && relative <= tolerance;
+    passed = passed && matched;
+    static_cast<void>(Logger(matched ? Logger::L_MSG : Logger::L_ERR
+          , std::to_string(tapCount) + (taps.is_dense() ? " dense" : " sparse")
+          + " taps differed from the direct sum by "
+          + std::to_string(relative) + " of the loudest sample"));
+  }
+
+  return passed;
+}
+
+/*!
+ *  Runs an impulse through a feedback delay network, checking the energy of
+ *  its tail falls by 60 dB over the T60 it was built for and that nothing
+ *  audible is left past the tail length renders are cut off at
+ *
+ *  \param t60
+ *    The seconds every band takes to decay by 60 dB
+ *  \param tolerance
+ *    The largest error allowed in the measured T60, relative to t60
+ *
+ *  \returns
+ *    If the network decays as it was built to
+ */
+bool test_reverb_decay(const float &t60 = 0.8f, const float &tolerance = 0.1f)
+{
+  const float samplingRate = 44100.f;
+  // Coprime delays around 34ms, as a scene a few meters across would use
+  const uint16_t delayList[] = {1499, 1511, 1523, 1531, 1543, 1549, 1553
+    , 1559, 1567, 1571};
+  CArray<uint16_t> delays;
+  for(const uint16_t &delay : delayList)
+  {
+    delays.push_back(delay);
+  }
+  CoefficentArray bands;
+  for(size_t i = 0; i < 4; ++i)
+  {
+    bands.push_back({125.f * static_cast<float>(1 << (2 * i)), t60});
+  }
+
+  FeedbackDelayNetwork reverb;
+  reverb.set_network(delays, bands, samplingRate);
+
+  // Run well past the tail length to see what a render would cut off
+  const size_t tailLength = reverb.get_tail_length();
+  const size_t size = 2 * tailLength;
+  std::vector<float> impulse(size, 0.f), output(size);
+  impulse[0] = 1.f;
+  reverb.process_block(impulse.data(), output.data(), size);
+
+  // The energy left from each sample on, the Schroeder decay curve
+  std::vector<double> remaining(size + 1, 0.0);
+  for(size_t i = size; i-- > 0;)
+  {
+    remaining[i] = remaining[i + 1] + static_cast<double>(output[i])
+      * output[i];
+  }
+  auto decibels = [&remaining](const size_t &i)
+  {
+    return 10.0 * std::log10(std::max(remaining[i], 1e-30) / remaining[0]);
+  };
+
+  // The T60 is measured over the -10 to -50 dB span of the curve, leaving
+  // out the first echoes and the noise floor
+  size_t begin = 0, end = 0;
+  while(begin < size && decibels(begin) > -10.0)
+  {
+    ++begin;
+  }
+  while(end < size && decibels(end) > -50.0)
+  {
+    ++end;
+  }
+  float measured = 1.5f * static_cast<float>(end - begin) / samplingRate;
+  double cutOff = decibels(tailLength + 1);
+
+  bool passed = remaining[0] > 0.0 && end < size
+    && std::fabs(measured - t60) <= tolerance * t60 && cutOff <= -55.0;
+  static_cast<void>(Logger(passed ? Logger::L_MSG : Logger::L_ERR
+        , "A reverb built for a T60 of " + std::to_string(t60)
+        + "s decayed with a T60 of " + std::to_string(measured)
+        + "s, leaving " + std::to_string(cutOff)
+        + " dB past its tail length"));
+
+  return passed;
+}
+
+/*!
+ *  Convolves noise with a background thread made to run late, checking the
+ *  late blocks are only left out and the head still matches convolving
+ *  without the thread
+ *
+ *  \param responseLength
+ *    The number of samples in the impulse response
+ *  \param blockCount
+ *    The number of blocks of input convolved
+ *  \param delay
+ *    The microseconds the background thread waits before each block
+ *
+ *  \returns
+ *    If the late background thread left the output intact
+ */
+bool test_threaded_convolver_late(const size_t &responseLength = 48000
+    , const size_t &blockCount = 512, const unsigned &delay = 20000)
+{
+  // Noise from a fixed seed so every run convolves the same samples
+  uint32_t state = 0x9e3779b9u;
+  auto next_noise = [&state]()
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return static_cast<float>(state) / 4294967296.f - 0.5f;
+  };
+
+  std::vector<float> response(responseLength);
+  for(size_t i = 0; i < responseLength; ++i)
+  {
+    response[i] = next_noise() * std::exp(-4.f * i / responseLength);
+  }
+
+  NonUniformConvolver reference, late;
+  reference.set_impulse_response(response.data(), response.size(), false);
+  late.set_impulse_response(response.data(), response.size(), true);
+  late.delay_background(delay);
+
+  const size_t blockSize = reference.get_block_size();
+  // Until the first segment starts only the head is heard
+  const size_t headLength = 8 * blockSize;
+  std::vector<float> input(blockSize), expected(blockSize)
+    , output(blockSize);
+  bool finite = true, headMatches = true;
+  for(size_t block = 0; block < blockCount; ++block)
+  {
+    for(float &sample : input)
+    {
+      sample = next_noise();
+    }
+
+    reference.process_block(input.data(), expected.data());
+    late.process_block(input.data(), output.data());
+    for(size_t i = 0; i < blockSize; ++i)
+    {
+      finite = finite && std::isfinite(output[i]);
+      if(block * blockSize + i < headLength && output[i] != expected[i])
+      {
+        headMatches = false;
+      }
+    }
+  }
+
+  size_t missed = late.get_missed_blocks();
+  bool passed = reference.get_missed_blocks() == 0 && missed > 0 && finite
+    && headMatches;
+  static_cast<void>(Logger(passed ? Logger::L_MSG : Logger::L_ERR
+        , "A late background convolver missed " + std::to_string(missed)
+        + " blocks, output finite: " + std::to_string(finite)
+        + ", head matched: " + std::to_string(headMatches)));
+
+  return passed;
+}
@@ -11,11 +11,23 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <fstream>
 #include <memory.h>
 #include <string>
+#include <vector>
 
+#include "audiobuffer.h"
 #include "helper.h"
 
+// The audio formats of the fmt chunk
+enum WAVE_FORMAT
+{
+  WF_PCM = 1
+  , WF_IEEE_FLOAT = 3
+  // The real format is given by the sub format of the chunk
+  , WF_EXTENSIBLE = 0xFFFE
+};
+
 // Default format for wave header
 /*!
  *  \struct WAVE_HEADER
@@ -50,6 +62,7 @@ struct WAVE_HEADER
    *    The header being copied
    */
   WAVE_HEADER(const WAVE_HEADER& header);
+  WAVE_HEADER &operator=(const WAVE_HEADER &header) = default;
 
   char riffLabel[4] = { 'R', 'I', 'F', 'F' };
   uint32_t riffSize = 0;
@@ -111,103 +124,12 @@ struct WAVE_HEADER
   
   /*!
    *  Reads in the data stored in the header data variable and saves it within
-   *  the rest of the wave header struct for ease of access
+   *  the rest of the wave header struct for ease of access. The format of an
+   *  extensible file is replaced by its sub format.
    */
   void read_wave_header(std::fstream &file);
 };
 
-struct SAMPLES
-{
-  private:
-    /*!
-     *  Default resize that doubles the size of the array
-     */
-    void resize();
-
-    size_t frameCount = 0;
-    float *sampleArray = nullptr;
-
-  public:
-    /*!
-     *  Default ctor for SAMPLES class, creating an empty array of samples
-     */
-    SAMPLES();
-    /*!
-     *  Deep copies in a given sample array into a newly created array
-     *
-     *  \param samples
-     *    The sample array being copied over
-     */
-    SAMPLES(const SAMPLES &samples);
-    ~SAMPLES();
-
-    /*!
-     *  Performs a deep copy of the given sample data into this SAMPLES object.
-     *  This operation will overwrite all current data with the new deep copied
-     *  data.
-     *
-     *  \param samples
-     *    The sample being copied from
-     *
-     *  \returns
-     *    A reference to the current sample object
-     */
-    SAMPLES &operator=(const SAMPLES &samples);
-
-    /*!
-     *  Gives the user a reference to a value at a given index within
-     *  the sample array.
-     *
-     *  NOTE: This will warn the user if the user attempts to dereference an 
-     *  index outside of the bounds of the array, BUT it will not throw an
-     *  error and will instead resize the array if possible.
-     *
-     *  \param index
-     *    The index we are fetching from within the array
-     *
-     *  \returns
-     *    A reference to the float stored at the given index
-     */
-    float &operator[](const size_t &index);
-
-    /*!
-     *  Resizes the array to a given size
-     *
-     *  \param _size
-     *    The size the array is being resized to
-     */
-    void resize(const size_t &_size);
-
-    /*!
-     *  A more robust approach to getting a value at a given index which wil
-     *  report an error if the index is outside the bounds of the array and
-     *  return the last value in the array.
-     *
-     *  \param index
-     *    The index being fetched from within the array
-     *
-     *  \returns
-     *    A const-reference to the value at the given index
-     */
-    const float &at(const size_t &index) const;
-    /*!
-     *  \returns
-     *    A pointer to the front of the array
-     */
-    const float *front() const;
-    /*!
-     *  \returns
-     *    The size of the array
-     */
-    const size_t size() const;
-
-    /*!
-     *  Clears the array of its contents, setting the size to 0 and array to
-     *  nullptr
-     */
-    void clear();
-};
-
 class WaveFile
 {
   public:
@@ -216,7 +138,7 @@ class WaveFile
      */
     WaveFile();
     /*!
-     *  Opens a given file for reading and creates a WAVE_HEADER and SAMPLES
+     *  Opens a given file for reading and creates a WAVE_HEADER and samples
      *  based on the files data
      *
      *  \param fileName
@@ -224,13 +146,23 @@ class WaveFile
      */
     WaveFile(const std::string &fileName);
     /*!
-     *  Performs a deep copy of a WaveFile, copying its WAVE_HEADER and SAMPLES
+     *  Performs a deep copy of a WaveFile, copying its WAVE_HEADER and samples
      *
      *  \param wave
      *    The wave file being deep copied
      */
     WaveFile(const WaveFile &wave);
+    /*!
+     *  Takes the header and samples of a WaveFile, leaving it closed
+     *
+     *  \param wave
+     *    The wave file being moved from
+     */
+    WaveFile(WaveFile &&wave) noexcept;
     ~WaveFile();
+
+    WaveFile &operator=(const WaveFile &wave);
+    WaveFile &operator=(WaveFile &&wave) noexcept;
  
     /*!
      *  Opens a .wav file at a given location, reading the header and samples
@@ -269,20 +201,20 @@ class WaveFile
     unsigned get_sampling_rate() const;
     /*!
      *  \returns
-     *    A reference to the CArray samples of the currently open WaveFile
+     *    A reference to the samples of the currently open WaveFile
      */
-    CArray<float> &get_samples();
+    AudioBuffer &get_samples();
   private:
     /*!
      *  Converts pcm values to float sample values and places them within 
-     *  the SAMPLES struct
+     *  the sample buffer
      *
      *  \param values
      *    A pointer to an array of chars that represent the pcm values
      */
-    void convert_from_pcm_values(char *values);
+    void convert_from_pcm_values(const char *values);
     /*!
-     *  Converts the float values stored within the SAMPLES struct into .wav
+     *  Converts the float values stored within the sample buffer into .wav
      *  file valid pcm values
      */
     char *convert_to_pcm_values();
@@ -292,5 +224,201 @@ class WaveFile
     std::string name;
 
     WAVE_HEADER header;
-    CArray<float> samples;
+    AudioBuffer samples;
+};
+
+/*!
+ *  \class WaveMap
+ *
+ *  \brief
+ *    A read-only view of the pcm values of a .wav file. On Linux the file is
+ *    memory mapped and its chunks are validated in place, so opening a file
+ *    takes the same time no matter its length and its pages are shared with
+ *    every other process reading it. Samples are only converted to floats as
+ *    they are read.
+ *
+ *    Where files can't be mapped the file is read into memory instead.
+ */
+class WaveMap
+{
+  public:
+    WaveMap();
+    // The mapping is owned by a single view
+    WaveMap(const WaveMap &other) = delete;
+    ~WaveMap();
+
+    WaveMap &operator=(const WaveMap &other) = delete;
+
+    /*!
+     *  \returns
+     *    If files are memory mapped rather than read into memory
+     */
+    static bool is_mapping_supported();
+
+    /*!
+     *  Maps a .wav file and validates its chunks
+     *
+     *  \param path
+     *    The path to the file being opened
+     *
+     *  \returns
+     *    If the file is a valid .wav file
+     */
+    bool open(const std::string &path);
+    void close();
+
+    bool is_open() const;
+    const WAVE_HEADER &get_header() const;
+    unsigned get_sampling_rate() const;
+    /*!
+     *  \returns
+     *    The number of samples in the file
+     */
+    size_t get_sample_count() const;
+    /*!
+     *  \returns
+     *    The pcm values of the file, as stored in the file
+     */
+    const char *get_values() const;
+
+    /*!
+     *  Converts samples of the file to floats
+     *
+     *  \param output
+     *    Where the samples are written
+     *  \param first
+     *    The first sample converted
+     *  \param count
+     *    The most samples to convert
+     *
+     *  \returns
+     *    The number of samples converted, less than count past the end of the
+     *    file
+     */
+    size_t read_samples(float *output, const size_t &first
+        , const size_t &count) const;
+
+  private:
+    WAVE_HEADER header;
+    const char *values = nullptr;
+    size_t sampleCount = 0;
+    // The mapped file
+    void *mapping = nullptr;
+    size_t mappingSize = 0;
+    // The file when it can't be mapped
+    std::vector<char> fileData;
+};
+
+/*!
+ *  \class WaveReader
+ *
+ *  \brief
+ *    Reads a .wav file a block at a time. The header is parsed once when the
+ *    file is opened and only a block of pcm values is held in memory, so
+ *    files of any length can be read. Where files can be memory mapped the
+ *    blocks are converted straight from the mapping.
+ */
+class WaveReader
+{
+  public:
+    WaveReader();
+    ~WaveReader();
+
+    /*!
+     *  Opens a .wav file and reads its header
+     *
+     *  \param fileName
+     *    The name or path to the file being opened
+     *  \param ignoreInputDir
+     *    Indicates if the given file is NOT in the input directory
+     *
+     *  \returns
+     *    If the file was opened
+     */
+    bool open(const std::string &fileName, const bool &ignoreInputDir = false);
+    void close();
+
+    bool is_open() const;
+    const WAVE_HEADER &get_header() const;
+    unsigned get_sampling_rate() const;
+    /*!
+     *  \returns
+     *    The number of samples in the file
+     */
+    size_t get_sample_count() const;
+
+    /*!
+     *  Reads the next samples of the file
+     *
+     *  \param output
+     *    Where the samples are written
+     *  \param count
+     *    The most samples to read
+     *
+     *  \returns
+     *    The number of samples read, less than count once the file ends
+     */
+    size_t read_block(float *output, const size_t &count);
+
+  private:
+    WaveMap map;
+    std::fstream file;
+    WAVE_HEADER header;
+    size_t sampleCount = 0;
+    size_t samplesRead = 0;
+    std::vector<char> pcmValues;
+};
+
+/*!
+ *  \class WaveWriter
+ *
+ *  \brief
+ *    Writes a .wav file a block at a time. The header is written with empty
+ *    sizes when the file is opened and patched with the real sizes once it
+ *    is closed, so the length doesn't need to be known up front.
+ */
+class WaveWriter
+{
+  public:
+    WaveWriter();
+    /*!
+     *  Closes the file if it is still open
+     */
+    ~WaveWriter();
+
+    /*!
+     *  Creates a .wav file and writes a placeholder header
+     *
+     *  \param fileName
+     *    The path of the file, .wav is added to the end
+     *  \param format
+     *    The format of the samples (i.e. the header of the input), only its
+     *    sampling rate, channels and bits per sample are used
+     *
+     *  \returns
+     *    If the file was created
+     */
+    bool open(const std::string &fileName, const WAVE_HEADER &format);
+    /*!
+     *  Patches the RIFF and data sizes in the header and closes the file
+     */
+    void close();
+
+    bool is_open() const;
+
+    /*!
+     *  Writes the next samples of the file
+     *
+     *  \param input
+     *    The samples being written
+     *  \param count
+     *    The number of samples
+     */
+    void write_block(const float *input, const size_t &count);
+
+  private:
+    std::ofstream file;
+    WAVE_HEADER header;
+    size_t samplesWritten = 0;
+    std::vector<char> pcmValues;
 };
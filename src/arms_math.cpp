@@ -117,3 +117,33 @@ float map_range_to(const float &value, const float &valueMin
   return (value - valueMin) / (valueMax - valueMin) 
     * (mapMax - mapMin) + mapMin;
 }
+
+bool line_line_intersection(const Vec2 &aBegin, const Vec2 &aEnd
+    , const Vec2 &bBegin, const Vec2 &bEnd, float &uA)
+{
+  float denominator = 
+    (
+      (bEnd.y - bBegin.y) * (aEnd.x - aBegin.x) 
+      - (bEnd.x - bBegin.x) * (aEnd.y - aBegin.y)
+    );
+
+  // Ignore parallel lines
+  if(denominator == 0)
+  {
+    return false;
+  }
+
+  // Normalized points of intersection
+  uA = 
+    (
+      (bEnd.x - bBegin.x) * (aBegin.y - bBegin.y) 
+      - (bEnd.y - bBegin.y) * (aBegin.x - bBegin.x)
+    ) / denominator;
+  float uB = 
+    (
+      (aEnd.x - aBegin.x) * (aBegin.y - bBegin.y) 
+      - (aEnd.y - aBegin.y) * (aBegin.x - bBegin.x)
+    ) / denominator;
+
+  return uA >= 0 && uA <= 1 && uB >= 0 && uB <= 1;
+}
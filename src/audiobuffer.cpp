@@ -0,0 +1,285 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   audiobuffer.cpp
+ *
+ *  \brief
+ *    Implementation of the aligned buffer audio samples are stored in
+ */
+
+#include "audiobuffer.h"
+
+#include <cstring>
+#include <new>
+
+// Transparent huge pages are asked for with madvise on Linux
+#if defined(__linux__)
+  #define ARMS_HUGE_PAGES 1
+  #include <sys/mman.h>
+#else
+  #define ARMS_HUGE_PAGES 0
+#endif
+
+#include "helper.h"
+
+using namespace std;
+
+namespace
+{
+  /*!
+   *  Allocates room for at least count samples
+   *
+   *  \param count
+   *    The number of samples needed
+   *  \param hugePages
+   *    If a large enough allocation should be backed by huge pages
+   *  \param capacity
+   *    Set to the number of samples actually allocated
+   *  \param alignment
+   *    Set to the alignment of the allocation, needed to free it
+   *
+   *  \returns
+   *    The allocation, never nullptr
+   */
+  float *allocate_samples(const size_t &count, const bool &hugePages
+      , size_t &capacity, size_t &alignment)
+  {
+    // Rounded up to whole cache lines so the allocator never has to split one
+    size_t bytes = count * sizeof(float);
+    bytes = (bytes + AudioBuffer::ALIGNMENT - 1)
+      / AudioBuffer::ALIGNMENT * AudioBuffer::ALIGNMENT;
+    alignment = AudioBuffer::ALIGNMENT;
+
+    const bool huge = hugePages && bytes >= AudioBuffer::HUGE_PAGE_SIZE;
+    if(huge)
+    {
+      // A huge page can only back a whole, aligned huge page
+      bytes = (bytes + AudioBuffer::HUGE_PAGE_SIZE - 1)
+        / AudioBuffer::HUGE_PAGE_SIZE * AudioBuffer::HUGE_PAGE_SIZE;
+      alignment = AudioBuffer::HUGE_PAGE_SIZE;
+    }
+
+    float *samples = static_cast<float *>(
+        ::operator new(bytes, align_val_t(alignment)));
+
+#if ARMS_HUGE_PAGES
+    if(huge)
+    {
+      // Only advice, the buffer still works when it is refused
+      madvise(samples, bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    capacity = bytes / sizeof(float);
+    return samples;
+  }
+}
+
+AudioBuffer::AudioBuffer() { }
+
+AudioBuffer::AudioBuffer(const size_t &initalCount)
+{
+  resize(initalCount);
+}
+
+AudioBuffer::AudioBuffer(const AudioBuffer &other)
+{
+  *this = other;
+}
+
+AudioBuffer::AudioBuffer(AudioBuffer &&other) noexcept
+  : head(other.head), count(other.count), reserved(other.reserved)
+  , alignment(other.alignment)
+{
+  other.head = nullptr;
+  other.count = 0;
+  other.reserved = 0;
+}
+
+AudioBuffer::~AudioBuffer()
+{
+  clear();
+}
+
+AudioBuffer &AudioBuffer::operator=(const AudioBuffer &other)
+{
+  if(this == &other)
+  {
+    return *this;
+  }
+
+  if(other.count == 0)
+  {
+    clear();
+    return *this;
+  }
+
+  // The current allocation is reused when it is large enough
+  resize_uninitialized(other.count);
+  memcpy(head, other.head, count * sizeof(float));
+
+  return *this;
+}
+
+AudioBuffer &AudioBuffer::operator=(AudioBuffer &&other) noexcept
+{
+  if(this == &other)
+  {
+    return *this;
+  }
+
+  clear();
+
+  head = other.head;
+  count = other.count;
+  reserved = other.reserved;
+  alignment = other.alignment;
+  other.head = nullptr;
+  other.count = 0;
+  other.reserved = 0;
+
+  return *this;
+}
+
+AudioBuffer &AudioBuffer::operator+=(const AudioBuffer &other)
+{
+  if(count != other.count)
+  {
+    static_cast<void>(Logger(Logger::L_WRN
+          , "AudioBuffer sizes do not match for += operation"));
+
+    if(count < other.count)
+    {
+      resize(other.count);
+    }
+  }
+
+  for(size_t i = 0; i < other.count; ++i)
+  {
+    head[i] += other.head[i];
+  }
+
+  return *this;
+}
+
+bool AudioBuffer::is_huge_page_supported()
+{
+  return ARMS_HUGE_PAGES;
+}
+
+void AudioBuffer::set_huge_pages(const bool &enabled)
+{
+  hugePagesEnabled.store(enabled, memory_order_relaxed);
+}
+
+const size_t &AudioBuffer::size() const
+{
+  return count;
+}
+
+const size_t &AudioBuffer::capacity() const
+{
+  return reserved;
+}
+
+const float *AudioBuffer::front() const
+{
+  return head;
+}
+
+float *AudioBuffer::data()
+{
+  return head;
+}
+
+const float *AudioBuffer::data() const
+{
+  return head;
+}
+
+float &AudioBuffer::operator[](const size_t &index)
+{
+  if(index >= count)
+  {
+    resize((index + 1) * 2);
+  }
+
+  return head[index];
+}
+
+const float &AudioBuffer::at(const size_t &index) const
+{
+  if(!head || count == 0)
+  {
+    throw "Calling at() when no valid value in AudioBuffer";
+  }
+
+  if(index >= count)
+  {
+    return head[count - 1];
+  }
+
+  return head[index];
+}
+
+void AudioBuffer::resize(const size_t &newSize)
+{
+  const size_t oldSize = count;
+  resize_uninitialized(newSize);
+
+  if(count > oldSize)
+  {
+    memset(head + oldSize, 0, (count - oldSize) * sizeof(float));
+  }
+}
+
+void AudioBuffer::resize_uninitialized(const size_t &newSize)
+{
+  if(newSize == 0)
+  {
+    clear();
+    return;
+  }
+
+  reserve(newSize);
+  count = newSize;
+}
+
+void AudioBuffer::reserve(const size_t &newCapacity)
+{
+  if(newCapacity <= reserved)
+  {
+    return;
+  }
+
+  size_t newReserved = 0, newAlignment = ALIGNMENT;
+  float *newHead = allocate_samples(newCapacity
+      , hugePagesEnabled.load(memory_order_relaxed) && ARMS_HUGE_PAGES
+      , newReserved, newAlignment);
+  if(count > 0)
+  {
+    memcpy(newHead, head, count * sizeof(float));
+  }
+
+  // Kept as clear() drops the size
+  const size_t kept = count;
+  clear();
+
+  head = newHead;
+  count = kept;
+  reserved = newReserved;
+  alignment = newAlignment;
+}
+
+void AudioBuffer::clear()
+{
+  if(head != nullptr)
+  {
+    ::operator delete(head, align_val_t(alignment));
+    head = nullptr;
+  }
+
+  count = 0;
+  reserved = 0;
+  alignment = ALIGNMENT;
+}
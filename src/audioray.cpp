@@ -14,7 +14,7 @@
 #include "audioray.h"
 #include "helper.h"
 
-AudioRay::AudioRay(Object *_parent, const int &_line, const CArray<Vec2> &amp
+AudioRay::AudioRay(Object *_parent, const int &_line, const CoefficentArray &amp
     , const Vec2 &_posA, const Vec2 &_posB)
     : parent(_parent), parentLine(_line), coefficents(amp)
 {
@@ -46,7 +46,7 @@ Vec2 AudioRay::get_posB() const
   return {line[1].position.x, line[1].position.y};
 }
 
-const CArray<Vec2> &AudioRay::get_amp() const
+const CoefficentArray &AudioRay::get_amp() const
 {
   return coefficents;
 }
@@ -74,7 +74,7 @@ void AudioRay::set_posB(const Vec2 &_posB)
   line[1].position = {_posB.x, _posB.y};
 }
 
-void AudioRay::set_amp(const CArray<Vec2> &amp)
+void AudioRay::set_amp(const CoefficentArray &amp)
 {
   coefficents = amp;
 }
@@ -87,7 +87,8 @@ void AudioRay::scale_amp(const float &scale)
   }
 }
 
-void AudioRay::scale_and_add_to_amp(const CArray<Vec2> &amp, const float &scale)
+void AudioRay::scale_and_add_to_amp(const CoefficentArray &amp
+    , const float &scale)
 {
   for(size_t i = 0; i < amp.size(); ++i)
   {
@@ -110,13 +111,12 @@ void AudioRay::scale_and_add_to_amp(const CArray<Vec2> &amp, const float &scale)
     // If the frequency doesn't already exists then add it
     if(newFreq)
     {
-      coefficents.resize(coefficents.size() + 1);
-      coefficents[coefficents.size() - 1] = {freq, (1.f - coefficent) * scale };
+      coefficents.push_back({freq, (1.f - coefficent) * scale});
     }
   }
 }
 
-void AudioRay::scale_to_amp(const CArray<Vec2> &amp, const float &scale)
+void AudioRay::scale_to_amp(const CoefficentArray &amp, const float &scale)
 {
   for(size_t i = 0; i < amp.size(); ++i)
   {
@@ -139,8 +139,7 @@ void AudioRay::scale_to_amp(const CArray<Vec2> &amp, const float &scale)
     // If the frequency doesn't already exists then add it
     if(newFreq)
     {
-      coefficents.resize(coefficents.size() + 1);
-      coefficents[coefficents.size() - 1] = {freq, (1.f - coefficent) * scale };
+      coefficents.push_back({freq, (1.f - coefficent) * scale});
     }
   }
 }
@@ -153,7 +152,7 @@ void AudioRay::inverse_amp()
   }
 }
 
-void AudioRay::add_to_amp(const CArray<Vec2> &amp)
+void AudioRay::add_to_amp(const CoefficentArray &amp)
 {
   for(size_t i = 0; i < amp.size(); ++i)
   {
@@ -176,15 +175,14 @@ void AudioRay::add_to_amp(const CArray<Vec2> &amp)
     // If the frequency doesn't already exists then add it
     if(newFreq)
     {
-      coefficents.resize(coefficents.size() + 1);
-      coefficents[coefficents.size() - 1] = {freq, 1.f - coefficent};
+      coefficents.push_back({freq, 1.f - coefficent});
     }
   }
 }
 
-CArray<Vec2> AudioRay::add_amps(const CArray<Vec2> &amp)
+CoefficentArray AudioRay::add_amps(const CoefficentArray &amp)
 {
-  CArray<Vec2> returnVec(coefficents);
+  CoefficentArray returnVec(coefficents);
 
   for(size_t i = 0; i < amp.size(); ++i)
   {
@@ -209,8 +207,7 @@ CArray<Vec2> AudioRay::add_amps(const CArray<Vec2> &amp)
     // If the frequency doesn't already exists then add it
     if(newFreq)
     {
-      returnVec.resize(returnVec.size() + 1);
-      returnVec[returnVec.size() - 1] = {freq, 1.f - coefficent};
+      returnVec.push_back({freq, 1.f - coefficent});
     }
   }
 
@@ -0,0 +1,134 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   bandgrid.cpp
+ *
+ *  \brief
+ *    Implementation of the fixed frequency bands energy is tracked in
+ */
+
+#include "bandgrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "barrier.h"
+#include "object.h"
+
+using namespace std;
+
+BandGrid::BandGrid() { }
+
+BandGrid::~BandGrid() { }
+
+void BandGrid::build(const vector<Object *> &objVec)
+{
+  float minFrequency = 0.f;
+  float maxFrequency = 0.f;
+  auto add_coefficents = [&](const CoefficentArray &coefficents)
+  {
+    for(size_t i = 0; i < coefficents.size(); ++i)
+    {
+      float frequency = coefficents.at(i).x;
+      if(frequency <= 0.f)
+      {
+        continue;
+      }
+
+      minFrequency = (minFrequency == 0.f) ? frequency
+        : min(minFrequency, frequency);
+      maxFrequency = max(maxFrequency, frequency);
+    }
+  };
+
+  for(Object *obj : objVec)
+  {
+    add_coefficents(obj->get_absortion_coefficent());
+  }
+  add_coefficents(Barrier::get_coefficent(Barrier::C_WALL));
+
+  // Default to the bands of the built in materials
+  if(minFrequency == 0.f)
+  {
+    minFrequency = 125.f;
+    maxFrequency = 4000.f;
+  }
+
+  int lowOctave = static_cast<int>(round(log2(minFrequency / 1000.f)));
+  int highOctave = static_cast<int>(round(log2(maxFrequency / 1000.f)));
+  lowOctave = max(MIN_OCTAVE, min(MAX_OCTAVE, lowOctave));
+  highOctave = max(lowOctave, min(MAX_OCTAVE, highOctave));
+  highOctave = min(highOctave
+      , lowOctave + static_cast<int>(BandEnergy::MAX_BANDS) - 1);
+
+  frequencies.clear();
+  for(int octave = lowOctave; octave <= highOctave; ++octave)
+  {
+    frequencies.push_back(1000.f * pow(2.f, static_cast<float>(octave)));
+  }
+
+  static_cast<void>(Logger(Logger::L_MSG, "Built band grid of "
+        + to_string(frequencies.size()) + " octaves from "
+        + to_string(frequencies.front()) + "Hz to "
+        + to_string(frequencies.back()) + "Hz"));
+}
+
+size_t BandGrid::size() const
+{
+  return frequencies.size();
+}
+
+float BandGrid::get_frequency(const size_t &band) const
+{
+  return frequencies[band];
+}
+
+BandEnergy BandGrid::resample_reflection(
+    const CoefficentArray &coefficents) const
+{
+  vector<Vec2> points;
+  for(size_t i = 0; i < coefficents.size(); ++i)
+  {
+    if(coefficents.at(i).x > 0.f)
+    {
+      points.push_back(coefficents.at(i));
+    }
+  }
+  sort(points.begin(), points.end()
+      , [](const Vec2 &a, const Vec2 &b) { return a.x < b.x; });
+
+  // Materials without coefficents don't absorb anything
+  BandEnergy reflection(1.f);
+  if(points.empty())
+  {
+    return reflection;
+  }
+
+  for(size_t band = 0; band < frequencies.size(); ++band)
+  {
+    float frequency = frequencies[band];
+    float absorbtion = points.back().y;
+    if(frequency <= points.front().x)
+    {
+      absorbtion = points.front().y;
+    }
+    else
+    {
+      for(size_t i = 1; i < points.size(); ++i)
+      {
+        if(frequency <= points[i].x)
+        {
+          float t = (log2(frequency) - log2(points[i - 1].x))
+            / (log2(points[i].x) - log2(points[i - 1].x));
+          absorbtion = points[i - 1].y + (points[i].y - points[i - 1].y) * t;
+          break;
+        }
+      }
+    }
+
+    reflection[band] = 1.f - max(0.f, min(1.f, absorbtion));
+  }
+
+  return reflection;
+}
@@ -68,7 +68,7 @@ Barrier::COEFFICENTS Barrier::get_next_free_custom_coefficent()
 {
   for(size_t i = C_CUSTOM0; i < C_COUNT; ++i)
   {
-    // INVALID COEFFICENT VALUE is an empty CArray<Vec2>
+    // INVALID COEFFICENT VALUE is an empty CoefficentArray
     // It also has no name
     if(EQCoefficentValues[i].name == "")
     {
@@ -109,7 +109,7 @@ Barrier::COEFFICENTS Barrier::get_coefficent_index(const string &name)
   return C_COUNT;
 }
 
-const CArray<Vec2> &Barrier::get_coefficent(const COEFFICENTS &index)
+const CoefficentArray &Barrier::get_coefficent(const COEFFICENTS &index)
 {
   if(index == C_COUNT)
   {
@@ -0,0 +1,344 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   collisiongrid.cpp
+ *
+ *  \brief
+ *    Implementation of the uniform grid used to speed up ray collisions
+ */
+
+#include "collisiongrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "helper.h"
+
+using namespace std;
+
+// Cells along the largest side of the grid are capped to keep the memory of
+// sparse scenes with a few huge objects reasonable
+const int MAX_GRID_CELLS = 512;
+
+CollisionGrid::CollisionGrid() { }
+
+CollisionGrid::~CollisionGrid() { }
+
+void CollisionGrid::build(const EdgeTable &_table)
+{
+  clear();
+
+  if(_table.size() == 0)
+  {
+    return;
+  }
+
+  table = &_table;
+  const uint32_t edgeCount = static_cast<uint32_t>(table->size());
+
+  // Find the bounds of all edges
+  Vec2 boundsMin = table->get_begin(0);
+  Vec2 boundsMax = table->get_begin(0);
+  for(uint32_t i = 0; i < edgeCount; ++i)
+  {
+    boundsMin.x = min({boundsMin.x, table->beginX[i], table->endX[i]});
+    boundsMin.y = min({boundsMin.y, table->beginY[i], table->endY[i]});
+    boundsMax.x = max({boundsMax.x, table->beginX[i], table->endX[i]});
+    boundsMax.y = max({boundsMax.y, table->beginY[i], table->endY[i]});
+  }
+
+  // Pad the bounds so the edges on the border are fully within the grid
+  Vec2 extent = boundsMax - boundsMin;
+  float padding = max(extent.x, extent.y) * 0.001f + 1.f;
+  origin = boundsMin - Vec2{padding, padding};
+  extent = extent + Vec2{2.f * padding, 2.f * padding};
+
+  // Aim for roughly one edge per cell
+  float cellLength = sqrt(extent.x * extent.y / static_cast<float>(edgeCount));
+  cellsX = max(1, min(MAX_GRID_CELLS
+        , static_cast<int>(ceil(extent.x / cellLength))));
+  cellsY = max(1, min(MAX_GRID_CELLS
+        , static_cast<int>(ceil(extent.y / cellLength))));
+  cellSize = {extent.x / cellsX, extent.y / cellsY};
+
+  // Edges are inserted into every cell their bounding box overlaps. The box is
+  // grown slightly so an edge lying on a cell border is in both cells.
+  const float epsilon = max(cellSize.x, cellSize.y) * 0.0001f;
+  auto for_each_cell = [&](const uint32_t &edge, auto func)
+  {
+    Vec2 edgeBegin = table->get_begin(edge);
+    Vec2 edgeEnd = table->get_end(edge);
+    int beginX, beginY, endX, endY;
+    get_cell({min(edgeBegin.x, edgeEnd.x) - epsilon
+        , min(edgeBegin.y, edgeEnd.y) - epsilon}, beginX, beginY);
+    get_cell({max(edgeBegin.x, edgeEnd.x) + epsilon
+        , max(edgeBegin.y, edgeEnd.y) + epsilon}, endX, endY);
+
+    for(int y = beginY; y <= endY; ++y)
+    {
+      for(int x = beginX; x <= endX; ++x)
+      {
+        func(y * cellsX + x);
+      }
+    }
+  };
+
+  // Count the edges of each cell and then fill them
+  cellStart.assign(cellsX * cellsY + 1, 0u);
+  for(uint32_t i = 0; i < edgeCount; ++i)
+  {
+    for_each_cell(i, [&](int cell) { ++cellStart[cell + 1]; });
+  }
+  for(size_t i = 1; i < cellStart.size(); ++i)
+  {
+    cellStart[i] += cellStart[i - 1];
+  }
+
+  vector<uint32_t> cellFill(cellStart.begin(), cellStart.end() - 1);
+  cellEdges.resize(cellStart.back());
+  cellBeginX.resize(cellStart.back());
+  cellBeginY.resize(cellStart.back());
+  cellEndX.resize(cellStart.back());
+  cellEndY.resize(cellStart.back());
+  for(uint32_t i = 0; i < edgeCount; ++i)
+  {
+    for_each_cell(i, [&](int cell)
+    {
+      uint32_t slot = cellFill[cell]++;
+      cellEdges[slot] = i;
+      cellBeginX[slot] = table->beginX[i];
+      cellBeginY[slot] = table->beginY[i];
+      cellEndX[slot] = table->endX[i];
+      cellEndY[slot] = table->endY[i];
+    });
+  }
+
+  static_cast<void>(Logger(Logger::L_MSG, "Built collision grid of "
+        + to_string(cellsX) + "x" + to_string(cellsY) + " cells for "
+        + to_string(edgeCount) + " edges"));
+}
+
+void CollisionGrid::clear()
+{
+  table = nullptr;
+  cellStart.clear();
+  cellEdges.clear();
+  cellBeginX.clear();
+  cellBeginY.clear();
+  cellEndX.clear();
+  cellEndY.clear();
+  cellsX = 0;
+  cellsY = 0;
+}
+
+bool CollisionGrid::is_built() const
+{
+  return !cellStart.empty();
+}
+
+uint32_t CollisionGrid::find_closest_edge(const Vec2 &rayBegin
+    , const Vec2 &rayEnd, const uint32_t &ignoreEdge, Vec2 &hitPos) const
+{
+  Vec2 direction = rayEnd - rayBegin;
+  CellWalk walk;
+  if(!is_built() || !begin_walk(rayBegin, direction, walk))
+  {
+    return EdgeTable::NO_EDGE;
+  }
+
+  // Hits are ordered by distance and then by edge order, the same as the
+  // brute force check, so both always agree
+  EdgeHit closest;
+
+  while(true)
+  {
+    // DO NOT CHECK PARENT AT REFLECTION LINE AS THIS WILL
+    // CAUSE COLLISION ERRORS
+    intersect_edges(get_cell_span(walk.cellY * cellsX + walk.cellX)
+        , rayBegin, rayEnd, ignoreEdge, closest);
+
+    // Any hit within the current cell can't be beaten by a later cell
+    if(closest.is_hit() && closest.u <= min(walk.tMaxX, walk.tMaxY))
+    {
+      break;
+    }
+
+    if(!step_walk(walk))
+    {
+      break;
+    }
+  }
+
+  if(closest.is_hit())
+  {
+    hitPos = rayBegin + direction * closest.u;
+  }
+
+  return closest.edge;
+}
+
+void CollisionGrid::find_closest_edges(const RayPacket &packet
+    , PacketHits &hits) const
+{
+  hits.clear();
+  if(!is_built())
+  {
+    return;
+  }
+
+  CellWalk walks[RayPacket::MAX_SIZE];
+  uint32_t activeMask = 0u;
+  for(size_t lane = 0; lane < packet.count; ++lane)
+  {
+    if(begin_walk({packet.beginX[lane], packet.beginY[lane]}
+          , {packet.directionX[lane], packet.directionY[lane]}, walks[lane]))
+    {
+      activeMask |= 1u << lane;
+    }
+  }
+
+  while(activeMask)
+  {
+    // Rays of a coherent packet are mostly in the same cell, so each cell is
+    // tested once against every ray currently inside it
+    uint32_t pendingMask = activeMask;
+    while(pendingMask)
+    {
+      int cell = get_walk_cell(walks[first_lane(pendingMask)]);
+      uint32_t cellMask = 0u;
+      for(uint32_t mask = pendingMask; mask; mask &= mask - 1u)
+      {
+        size_t lane = first_lane(mask);
+        if(get_walk_cell(walks[lane]) == cell)
+        {
+          cellMask |= 1u << lane;
+        }
+      }
+
+      intersect_ray_packet(get_cell_span(cell), packet, cellMask, hits);
+      pendingMask &= ~cellMask;
+    }
+
+    // Each ray then leaves the packet once it has its hit or leaves the grid
+    for(uint32_t mask = activeMask; mask; mask &= mask - 1u)
+    {
+      size_t lane = first_lane(mask);
+      CellWalk &walk = walks[lane];
+      if((hits.edge[lane] != EdgeTable::NO_EDGE
+            && hits.u[lane] <= min(walk.tMaxX, walk.tMaxY))
+          || !step_walk(walk))
+      {
+        activeMask &= ~(1u << lane);
+      }
+    }
+  }
+}
+
+bool CollisionGrid::begin_walk(const Vec2 &rayBegin, const Vec2 &direction
+    , CellWalk &walk) const
+{
+  const float INF = numeric_limits<float>::infinity();
+
+  // Clip the ray to the bounds of the grid
+  float tEnter = 0.f;
+  walk.tExit = 1.f;
+  const float rayPos[2] = {rayBegin.x, rayBegin.y};
+  const float rayDir[2] = {direction.x, direction.y};
+  const float boundsMin[2] = {origin.x, origin.y};
+  const float boundsMax[2] = {origin.x + cellSize.x * cellsX
+    , origin.y + cellSize.y * cellsY};
+  for(int axis = 0; axis < 2; ++axis)
+  {
+    if(rayDir[axis] == 0.f)
+    {
+      if(rayPos[axis] < boundsMin[axis] || rayPos[axis] > boundsMax[axis])
+      {
+        return false;
+      }
+      continue;
+    }
+
+    float t0 = (boundsMin[axis] - rayPos[axis]) / rayDir[axis];
+    float t1 = (boundsMax[axis] - rayPos[axis]) / rayDir[axis];
+    tEnter = max(tEnter, min(t0, t1));
+    walk.tExit = min(walk.tExit, max(t0, t1));
+  }
+
+  if(tEnter > walk.tExit)
+  {
+    return false;
+  }
+
+  // Setup the DDA walk from the cell the ray enters the grid in
+  get_cell(rayBegin + direction * tEnter, walk.cellX, walk.cellY);
+
+  walk.stepX = (direction.x > 0.f) ? 1 : ((direction.x < 0.f) ? -1 : 0);
+  walk.stepY = (direction.y > 0.f) ? 1 : ((direction.y < 0.f) ? -1 : 0);
+  walk.tDeltaX = walk.stepX ? cellSize.x / abs(direction.x) : INF;
+  walk.tDeltaY = walk.stepY ? cellSize.y / abs(direction.y) : INF;
+  walk.tMaxX = walk.stepX
+    ? (origin.x + (walk.cellX + (walk.stepX > 0)) * cellSize.x - rayBegin.x)
+      / direction.x
+    : INF;
+  walk.tMaxY = walk.stepY
+    ? (origin.y + (walk.cellY + (walk.stepY > 0)) * cellSize.y - rayBegin.y)
+      / direction.y
+    : INF;
+
+  return true;
+}
+
+bool CollisionGrid::step_walk(CellWalk &walk) const
+{
+  if(min(walk.tMaxX, walk.tMaxY) > walk.tExit)
+  {
+    return false;
+  }
+
+  if(walk.tMaxX < walk.tMaxY)
+  {
+    walk.cellX += walk.stepX;
+    walk.tMaxX += walk.tDeltaX;
+  }
+  else
+  {
+    walk.cellY += walk.stepY;
+    walk.tMaxY += walk.tDeltaY;
+  }
+
+  return walk.cellX >= 0 && walk.cellX < cellsX
+    && walk.cellY >= 0 && walk.cellY < cellsY;
+}
+
+int CollisionGrid::get_walk_cell(const CellWalk &walk) const
+{
+  return walk.cellY * cellsX + walk.cellX;
+}
+
+EdgeSpan CollisionGrid::get_cell_span(const int &cell) const
+{
+  uint32_t first = cellStart[cell];
+  return EdgeSpan{cellBeginX.data() + first, cellBeginY.data() + first
+    , cellEndX.data() + first, cellEndY.data() + first
+    , cellEdges.data() + first, 0u, cellStart[cell + 1] - first};
+}
+
+size_t CollisionGrid::first_lane(const uint32_t &mask)
+{
+  size_t lane = 0;
+  while(!(mask & (1u << lane)))
+  {
+    ++lane;
+  }
+  return lane;
+}
+
+void CollisionGrid::get_cell(const Vec2 &pos, int &cellX, int &cellY) const
+{
+  cellX = static_cast<int>(floor((pos.x - origin.x) / cellSize.x));
+  cellY = static_cast<int>(floor((pos.y - origin.y) / cellSize.y));
+  cellX = max(0, min(cellsX - 1, cellX));
+  cellY = max(0, min(cellsY - 1, cellY));
+}
@@ -0,0 +1,352 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   convolution.cpp
+ *
+ *  \brief
+ *    Implementation of the partitioned convolution engines
+ */
+
+#include "convolution.h"
+
+#include <algorithm>
+#include <string>
+
+#include "helper.h"
+
+using namespace std;
+
+UniformConvolver::UniformConvolver() { }
+
+UniformConvolver::~UniformConvolver() { }
+
+void UniformConvolver::set_impulse_response(const float *response
+    , const size_t &length, const size_t &_blockSize)
+{
+  blockSize = _blockSize;
+  partitionCount = (length + blockSize - 1) / blockSize;
+  // Blocks are convolved with twice their size so the result of the current
+  // block never wraps around
+  fft.resize(2 * blockSize);
+
+  const size_t binCount = fft.get_bin_count();
+  partitions.assign(partitionCount * binCount, Complex());
+  vector<float> padded(2 * blockSize);
+  for(size_t p = 0; p < partitionCount; ++p)
+  {
+    size_t begin = p * blockSize;
+    size_t count = min(blockSize, length - begin);
+    fill(padded.begin(), padded.end(), 0.f);
+    copy(response + begin, response + begin + count, padded.begin());
+    fft.forward(padded.data(), partitions.data() + p * binCount);
+  }
+
+  delayLine.assign(partitionCount * binCount, Complex());
+  inputBuffer.assign(2 * blockSize, 0.f);
+  spectrum.assign(binCount, Complex());
+  outputBuffer.assign(2 * blockSize, 0.f);
+  delayHead = 0;
+
+  static_cast<void>(Logger(Logger::L_MSG, "Partitioned a response of "
+        + to_string(length) + " samples into " + to_string(partitionCount)
+        + " blocks of " + to_string(blockSize)));
+}
+
+void UniformConvolver::reset()
+{
+  fill(delayLine.begin(), delayLine.end(), Complex());
+  fill(inputBuffer.begin(), inputBuffer.end(), 0.f);
+  delayHead = 0;
+}
+
+bool UniformConvolver::is_valid() const
+{
+  return partitionCount > 0;
+}
+
+size_t UniformConvolver::get_block_size() const
+{
+  return blockSize;
+}
+
+size_t UniformConvolver::get_partition_count() const
+{
+  return partitionCount;
+}
+
+void UniformConvolver::process_block(const float *input, float *output)
+{
+  const size_t binCount = fft.get_bin_count();
+
+  // Slide the input so the buffer holds the previous and current block
+  copy(inputBuffer.begin() + blockSize, inputBuffer.end()
+      , inputBuffer.begin());
+  copy(input, input + blockSize, inputBuffer.begin() + blockSize);
+
+  // The newest spectrum replaces the oldest in the delay line
+  delayHead = (delayHead == 0) ? partitionCount - 1 : delayHead - 1;
+  fft.forward(inputBuffer.data(), delayLine.data() + delayHead * binCount);
+
+  // Partition p is applied to the input from p blocks ago
+  fill(spectrum.begin(), spectrum.end(), Complex());
+  for(size_t p = 0; p < partitionCount; ++p)
+  {
+    const Complex *partition = partitions.data() + p * binCount;
+    const Complex *delayed = delayLine.data()
+      + ((delayHead + p) % partitionCount) * binCount;
+    for(size_t i = 0; i < binCount; ++i)
+    {
+      spectrum[i] += complex_multiply(delayed[i], partition[i]);
+    }
+  }
+
+  fft.inverse(spectrum.data(), outputBuffer.data());
+
+  // The first half wrapped around with the previous block, only the second
+  // half is valid
+  copy(outputBuffer.begin() + blockSize, outputBuffer.end(), output);
+}
+
+NonUniformConvolver::NonUniformConvolver() { }
+
+NonUniformConvolver::~NonUniformConvolver()
+{
+  clear();
+}
+
+void NonUniformConvolver::set_impulse_response(const float *response
+    , const size_t &length, const bool &_threaded)
+{
+  clear();
+  threaded = _threaded;
+
+  if(length == 0)
+  {
+    return;
+  }
+
+  // The head covers the response until the first segment can start
+  size_t blockSize = HEAD_BLOCK_SIZE * 4;
+  size_t offset = min(length, 2 * blockSize);
+  head.set_impulse_response(response, offset, HEAD_BLOCK_SIZE);
+
+  while(offset < length)
+  {
+    size_t nextBlockSize = min(blockSize * 4, MAX_BLOCK_SIZE);
+    // The largest segment covers the rest of the response
+    size_t end = (nextBlockSize > blockSize)
+      ? min(length, 2 * nextBlockSize) : length;
+
+    unique_ptr<Segment> segment = make_unique<Segment>();
+    segment->engine.set_impulse_response(response + offset, end - offset
+        , blockSize);
+    segment->offset = offset;
+    segment->blockSize = blockSize;
+    segment->inputBlocks.assign(2 * blockSize, 0.f);
+    segment->outputRing.assign(FFT::get_power_of_two(offset + 2 * blockSize)
+        , 0.f);
+    segment->ringMask = segment->outputRing.size() - 1;
+    segment->ringBlocks.assign(segment->outputRing.size() / blockSize, 0);
+    segment->work.assign(blockSize, 0.f);
+    segments.push_back(move(segment));
+
+    offset = end;
+    blockSize = nextBlockSize;
+  }
+
+  static_cast<void>(Logger(Logger::L_MSG, "Split a response of "
+        + to_string(length) + " samples into a head and "
+        + to_string(segments.size()) + " background segments"));
+
+  if(threaded && !segments.empty())
+  {
+    running = true;
+    background = thread(&NonUniformConvolver::run_background, this);
+  }
+}
+
+void NonUniformConvolver::clear()
+{
+  if(background.joinable())
+  {
+    {
+      lock_guard<mutex> lock(wakeMutex);
+      running = false;
+    }
+    wake.notify_one();
+    background.join();
+  }
+
+  head = UniformConvolver();
+  segments.clear();
+  time = 0;
+  missedBlocks = 0;
+}
+
+bool NonUniformConvolver::is_valid() const
+{
+  return head.is_valid();
+}
+
+size_t NonUniformConvolver::get_block_size() const
+{
+  return HEAD_BLOCK_SIZE;
+}
+
+size_t NonUniformConvolver::get_missed_blocks() const
+{
+  return missedBlocks.load();
+}
+
+void NonUniformConvolver::process_block(const float *input, float *output)
+{
+  // Hand the input to the segments first as output may overwrite it
+  bool requested = false;
+  for(unique_ptr<Segment> &segment : segments)
+  {
+    collect_segment_block(*segment);
+
+    float *blockInput = segment->inputBlocks.data()
+      + segment->fillHalf * segment->blockSize;
+    copy(input, input + HEAD_BLOCK_SIZE, blockInput + segment->filled);
+    segment->filled += HEAD_BLOCK_SIZE;
+    if(segment->filled < segment->blockSize)
+    {
+      continue;
+    }
+
+    segment->filled = 0;
+    size_t block = segment->blockCount++;
+    size_t handed = segment->requested.load(memory_order_relaxed);
+    // A background thread still on the previous block is late, so this
+    // block is dropped rather than written over while it could be read
+    if(threaded && (!segment->collected
+          || segment->completed.load(memory_order_acquire) < handed))
+    {
+      segment->dropped = true;
+      continue;
+    }
+
+    segment->workHalf = segment->fillHalf;
+    segment->fillHalf ^= 1u;
+    segment->workBlock = block;
+    segment->resetEngine = segment->dropped;
+    segment->dropped = false;
+    segment->collected = false;
+    if(threaded)
+    {
+      segment->requested.store(handed + 1, memory_order_release);
+      requested = true;
+    }
+    else
+    {
+      convolve_segment_block(*segment);
+      segment->requested.store(handed + 1, memory_order_relaxed);
+      segment->completed.store(handed + 1, memory_order_relaxed);
+      collect_segment_block(*segment);
+    }
+  }
+  if(requested)
+  {
+    wake.notify_one();
+  }
+
+  head.process_block(input, output);
+
+  // Blocks and offsets are multiples of the head's blocks, so the output of
+  // this call always falls within a single block of each segment
+  for(unique_ptr<Segment> &segment : segments)
+  {
+    if(time < segment->offset)
+    {
+      continue;
+    }
+
+    size_t block = (time - segment->offset) / segment->blockSize;
+    size_t ringBlock = (time / segment->blockSize)
+      % segment->ringBlocks.size();
+    if(segment->ringBlocks[ringBlock] != block + 1)
+    {
+      ++missedBlocks;
+      continue;
+    }
+
+    const float *ring = segment->outputRing.data();
+    for(size_t i = 0; i < HEAD_BLOCK_SIZE; ++i)
+    {
+      output[i] += ring[(time + i) & segment->ringMask];
+    }
+  }
+
+  time += HEAD_BLOCK_SIZE;
+}
+
+void NonUniformConvolver::delay_background(const unsigned &microseconds)
+{
+  backgroundDelay = microseconds;
+}
+
+void NonUniformConvolver::convolve_segment_block(Segment &segment)
+{
+  if(segment.resetEngine)
+  {
+    segment.engine.reset();
+  }
+
+  const float *blockInput = segment.inputBlocks.data()
+    + segment.workHalf * segment.blockSize;
+  segment.engine.process_block(blockInput, segment.work.data());
+}
+
+void NonUniformConvolver::collect_segment_block(Segment &segment)
+{
+  if(segment.collected || segment.completed.load(memory_order_acquire)
+      < segment.requested.load(memory_order_relaxed))
+  {
+    return;
+  }
+
+  // The segment's output plays offset samples after its input
+  size_t playTime = segment.workBlock * segment.blockSize + segment.offset;
+  for(size_t i = 0; i < segment.blockSize; ++i)
+  {
+    segment.outputRing[(playTime + i) & segment.ringMask] = segment.work[i];
+  }
+  segment.ringBlocks[(playTime / segment.blockSize)
+    % segment.ringBlocks.size()] = segment.workBlock + 1;
+  segment.collected = true;
+}
+
+void NonUniformConvolver::run_background()
+{
+  while(running)
+  {
+    // Smaller segments have closer deadlines so they always go first
+    bool worked = false;
+    for(unique_ptr<Segment> &segment : segments)
+    {
+      size_t block = segment->completed.load(memory_order_relaxed);
+      if(block < segment->requested.load(memory_order_acquire))
+      {
+        unsigned delay = backgroundDelay.load(memory_order_relaxed);
+        if(delay > 0)
+        {
+          this_thread::sleep_for(chrono::microseconds(delay));
+        }
+
+        convolve_segment_block(*segment);
+        segment->completed.store(block + 1, memory_order_release);
+        worked = true;
+        break;
+      }
+    }
+
+    if(!worked)
+    {
+      // The audio thread doesn't lock when it wakes this thread, so a wake
+      // can be missed and the timeout picks it up instead
+      unique_lock<mutex> lock(wakeMutex);
+      wake.wait_for(lock, chrono::milliseconds(1));
+    }
+  }
+}
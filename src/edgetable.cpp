@@ -0,0 +1,195 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   edgetable.cpp
+ *
+ *  \brief
+ *    Implementation of the flat edge table the ray tracer collides against
+ */
+
+#include "edgetable.h"
+
+#include <array>
+#include <string>
+
+#include "barrier.h"
+#include "listener2.h"
+#include "object.h"
+
+using namespace std;
+
+EdgeTable::EdgeTable() { }
+
+EdgeTable::~EdgeTable() { }
+
+void EdgeTable::compile(const vector<Object *> &objVec, const Vec2 &roomPos
+    , const Vec2 &roomSize, const Vec2 &scalar, const BandGrid &grid)
+{
+  clear();
+  bandCount = grid.size();
+
+  for(size_t i = 0; i < objVec.size(); ++i)
+  {
+    Object *obj = objVec[i];
+    string typeName = obj->get_type_name();
+
+    // NOTE: Sources are ignored for collisions as rays start in the middle of
+    // the source box
+    if(typeName == "Source")
+    {
+      continue;
+    }
+
+    // Rays pass through volumetric listeners rather than colliding
+    if(typeName == "Listener" && static_cast<Listener *>(obj)
+        ->get_receiver_mode() == Listener::R_VOLUME)
+    {
+      continue;
+    }
+
+    if(typeName == "Barrier")
+    {
+      uint16_t material = add_material(obj->get_absortion_coefficent()
+          , static_cast<Barrier *>(obj)->get_type_data(), grid);
+      add_edges(obj, obj->get_position(), obj->get_size(), EK_BARRIER
+          , material, scalar);
+    }
+    else
+    {
+      // Non barrier objects don't share materials so they are keyed by their
+      // index in the scene instead
+      uint16_t material = add_material(obj->get_absortion_coefficent()
+          , -1 - static_cast<int>(i), grid);
+      add_edges(obj, obj->get_position(), obj->get_size()
+          , (typeName == "Listener") ? EK_LISTENER : EK_BARRIER
+          , material, scalar);
+    }
+  }
+
+  // The room walls are always last so they lose any ties in distance
+  uint16_t wallMaterial = add_material(
+      Barrier::get_coefficent(Barrier::C_WALL), Barrier::C_WALL, grid);
+  add_edges(nullptr, roomPos, roomSize, EK_WALL, wallMaterial, scalar);
+
+  static_cast<void>(Logger(Logger::L_MSG, "Compiled edge table with "
+        + to_string(size()) + " edges and " + to_string(materials.size())
+        + " materials"));
+}
+
+void EdgeTable::clear()
+{
+  beginX.clear();
+  beginY.clear();
+  endX.clear();
+  endY.clear();
+  normalX.clear();
+  normalY.clear();
+  materialId.clear();
+  kind.clear();
+  line.clear();
+  owner.clear();
+  materials.clear();
+  materialKeys.clear();
+  bandCount = 0;
+}
+
+size_t EdgeTable::size() const
+{
+  return beginX.size();
+}
+
+size_t EdgeTable::get_band_count() const
+{
+  return bandCount;
+}
+
+Vec2 EdgeTable::get_begin(const uint32_t &edge) const
+{
+  return {beginX[edge], beginY[edge]};
+}
+
+Vec2 EdgeTable::get_end(const uint32_t &edge) const
+{
+  return {endX[edge], endY[edge]};
+}
+
+Vec2 EdgeTable::get_normal(const uint32_t &edge) const
+{
+  return {normalX[edge], normalY[edge]};
+}
+
+EdgeTable::EDGE_KIND EdgeTable::get_kind(const uint32_t &edge) const
+{
+  return static_cast<EDGE_KIND>(kind[edge]);
+}
+
+int EdgeTable::get_line(const uint32_t &edge) const
+{
+  return line[edge];
+}
+
+Object *EdgeTable::get_owner(const uint32_t &edge) const
+{
+  return owner[edge];
+}
+
+Listener *EdgeTable::get_listener(const uint32_t &edge) const
+{
+  // The kind was checked when compiled so no dynamic_cast is needed
+  return static_cast<Listener *>(owner[edge]);
+}
+
+const BandEnergy &EdgeTable::get_material(const uint32_t &edge) const
+{
+  return materials[materialId[edge]];
+}
+
+void EdgeTable::add_edges(Object *obj, const Vec2 &pos, const Vec2 &size
+    , const EDGE_KIND &edgeKind, const uint16_t &material, const Vec2 &scalar)
+{
+  std::array<Vec2, 4> objLines =
+  {
+    Vec2{pos},
+    Vec2{pos.x + size.x, pos.y},
+    Vec2{pos.x + size.x, pos.y + size.y},
+    Vec2{pos.x, pos.y + size.y}
+  };
+
+  for(int i = 0; i < 4; ++i)
+  {
+    const Vec2 &lineBegin = objLines[i];
+    const Vec2 &lineEnd = objLines[(i + 1) % 4];
+
+    // Normal of the line in physical space based on scene size
+    Vec2 lineDirection = lineEnd / scalar - lineBegin / scalar;
+    Vec2 normalVec(-lineDirection.y, lineDirection.x);
+    normalVec.normalize();
+
+    beginX.push_back(lineBegin.x);
+    beginY.push_back(lineBegin.y);
+    endX.push_back(lineEnd.x);
+    endY.push_back(lineEnd.y);
+    normalX.push_back(normalVec.x);
+    normalY.push_back(normalVec.y);
+    materialId.push_back(material);
+    kind.push_back(static_cast<uint8_t>(edgeKind));
+    line.push_back(static_cast<uint8_t>(i));
+    owner.push_back(obj);
+  }
+}
+
+uint16_t EdgeTable::add_material(const CoefficentArray &coefficents
+    , const int &key, const BandGrid &grid)
+{
+  for(size_t i = 0; i < materialKeys.size(); ++i)
+  {
+    if(materialKeys[i] == key)
+    {
+      return static_cast<uint16_t>(i);
+    }
+  }
+
+  materials.push_back(grid.resample_reflection(coefficents));
+  materialKeys.push_back(key);
+  return static_cast<uint16_t>(materials.size() - 1);
+}
@@ -0,0 +1,204 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   fft.cpp
+ *
+ *  \brief
+ *    Implementation of the fast fourier transform used for convolution
+ */
+
+#include "fft.h"
+
+#include <cmath>
+#include <utility>
+
+#include "helper.h"
+
+using namespace std;
+
+FFT::FFT(const size_t &_size)
+{
+  if(_size > 0)
+  {
+    resize(_size);
+  }
+}
+
+FFT::~FFT() { }
+
+void FFT::resize(const size_t &_size)
+{
+  if(_size < 2 || (_size & (_size - 1)) != 0)
+  {
+    static_cast<void>(Logger(Logger::L_ERR, "FFT size must be a power of two"
+          + string(" of at least 2, got: ") + to_string(_size)));
+    return;
+  }
+
+  count = _size;
+  const size_t half = count / 2;
+  const double TWOPI = 8.0 * atan(1.0);
+
+  twiddles.resize(half / 2 + 1);
+  for(size_t i = 0; i < twiddles.size(); ++i)
+  {
+    double angle = -TWOPI * static_cast<double>(i) / static_cast<double>(half);
+    twiddles[i] = Complex(static_cast<float>(cos(angle))
+        , static_cast<float>(sin(angle)));
+  }
+
+  realTwiddles.resize(half + 1);
+  for(size_t i = 0; i < realTwiddles.size(); ++i)
+  {
+    double angle = -TWOPI * static_cast<double>(i) / static_cast<double>(count);
+    realTwiddles[i] = Complex(static_cast<float>(cos(angle))
+        , static_cast<float>(sin(angle)));
+  }
+
+  bitReverse.resize(half);
+  size_t bits = 0;
+  while((static_cast<size_t>(1) << bits) < half)
+  {
+    ++bits;
+  }
+  for(size_t i = 0; i < half; ++i)
+  {
+    uint32_t reversed = 0;
+    for(size_t b = 0; b < bits; ++b)
+    {
+      reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+    }
+    bitReverse[i] = reversed;
+  }
+}
+
+size_t FFT::size() const
+{
+  return count;
+}
+
+size_t FFT::get_bin_count() const
+{
+  return count / 2 + 1;
+}
+
+size_t FFT::get_power_of_two(const size_t &value)
+{
+  size_t power = 1;
+  while(power < value)
+  {
+    power <<= 1;
+  }
+
+  return power;
+}
+
+void FFT::transform(Complex *data, const bool &inverse) const
+{
+  const size_t half = count / 2;
+
+  for(size_t i = 0; i < half; ++i)
+  {
+    if(i < bitReverse[i])
+    {
+      swap(data[i], data[bitReverse[i]]);
+    }
+  }
+
+  for(size_t length = 2; length <= half; length <<= 1)
+  {
+    const size_t halfLength = length / 2;
+    const size_t step = half / length;
+    for(size_t block = 0; block < half; block += length)
+    {
+      for(size_t j = 0; j < halfLength; ++j)
+      {
+        // Only the first quarter turn is stored, the rest is a rotation of it
+        size_t index = j * step;
+        Complex twiddle = (index < twiddles.size()) ? twiddles[index]
+          : Complex(twiddles[index - half / 4].imag()
+              , -twiddles[index - half / 4].real());
+        if(inverse)
+        {
+          twiddle = conj(twiddle);
+        }
+
+        Complex odd = complex_multiply(twiddle, data[block + j + halfLength]);
+        Complex even = data[block + j];
+        data[block + j] = even + odd;
+        data[block + j + halfLength] = even - odd;
+      }
+    }
+  }
+}
+
+void FFT::forward(const float *input, Complex *output) const
+{
+  const size_t half = count / 2;
+
+  // Pack the even samples into the real part and odd samples into the
+  // imaginary part of a complex signal of half the size
+  for(size_t i = 0; i < half; ++i)
+  {
+    output[i] = Complex(input[2 * i], input[2 * i + 1]);
+  }
+
+  transform(output, false);
+
+  // Split the spectrum of the packed signal into the spectrum of the even
+  // and odd samples then join them into the spectrum of the real signal
+  Complex first = output[0];
+  output[0] = Complex(first.real() + first.imag(), 0.f);
+  output[half] = Complex(first.real() - first.imag(), 0.f);
+
+  for(size_t k = 1; k <= half / 2; ++k)
+  {
+    Complex z = output[k];
+    Complex zMirror = conj(output[half - k]);
+
+    Complex even = (z + zMirror) * 0.5f;
+    Complex odd = (z - zMirror) * Complex(0.f, -0.5f);
+    Complex evenMirror = conj(even);
+    Complex oddMirror = conj(odd);
+
+    output[k] = even + complex_multiply(realTwiddles[k], odd);
+    output[half - k] = evenMirror
+      + complex_multiply(realTwiddles[half - k], oddMirror);
+  }
+}
+
+void FFT::inverse(Complex *input, float *output) const
+{
+  const size_t half = count / 2;
+
+  // Undo the join of forward back into the spectrum of the packed signal
+  Complex first = input[0];
+  Complex last = input[half];
+  input[0] = Complex((first.real() + last.real()) * 0.5f
+      , (first.real() - last.real()) * 0.5f);
+
+  for(size_t k = 1; k <= half / 2; ++k)
+  {
+    Complex x = input[k];
+    Complex xMirror = conj(input[half - k]);
+
+    Complex even = (x + xMirror) * 0.5f;
+    Complex odd = complex_multiply((x - xMirror) * 0.5f
+        , conj(realTwiddles[k]));
+    Complex evenMirror = conj(even);
+    Complex oddMirror = conj(odd);
+
+    input[k] = even + complex_multiply(Complex(0.f, 1.f), odd);
+    input[half - k] = evenMirror + complex_multiply(Complex(0.f, 1.f)
+        , oddMirror);
+  }
+
+  transform(input, true);
+
+  const float scale = 1.f / static_cast<float>(half);
+  for(size_t i = 0; i < half; ++i)
+  {
+    output[2 * i] = input[i].real() * scale;
+    output[2 * i + 1] = input[i].imag() * scale;
+  }
+}
@@ -9,57 +9,283 @@
 
 #include "filter.h"
 
+#include <algorithm>
 #include <cmath>
 #include <math.h>
 
 #include "helper.h"
+#include "simd.h"
 
 using namespace std;
 
+namespace
+{
+  /*!
+   *  Sums the 8 lanes in the same order as the vector kernels: the halves,
+   *  then the pairs, then the last two, so every kernel gives identical
+   *  output
+   */
+  inline float sum_lanes(const float *lanes)
+  {
+    float half[4];
+    for(size_t i = 0; i < 4; ++i)
+    {
+      half[i] = lanes[i] + lanes[i + 4];
+    }
+
+    return (half[0] + half[2]) + (half[1] + half[3]);
+  }
+
+  // output[i] += sum of every band's biquad of input[i]
+  void biquad_lanes_scalar(BIQUAD_LANES &lanes, const float *input
+      , const size_t &size, float *output)
+  {
+    const size_t LANES = BIQUAD_LANES::LANES;
+    float x1 = lanes.x1, x2 = lanes.x2;
+    float *y1 = lanes.y1, *y2 = lanes.y2;
+    float scaled[LANES];
+    for(size_t i = 0; i < size; ++i)
+    {
+      const float x = input[i];
+      for(size_t j = 0; j < LANES; ++j)
+      {
+        float y = lanes.b0[j] * x + lanes.b1[j] * x1 + lanes.b2[j] * x2
+          - lanes.a1[j] * y1[j] - lanes.a2[j] * y2[j];
+        y2[j] = y1[j];
+        y1[j] = y;
+        scaled[j] = y * lanes.gain[j];
+      }
+
+      x2 = x1;
+      x1 = x;
+      output[i] += sum_lanes(scaled);
+    }
+
+    lanes.x1 = x1;
+    lanes.x2 = x2;
+  }
+
+#if ARMS_SSE2
+  // Both halves of the lanes are independent recursions so they overlap
+  void biquad_lanes_sse(BIQUAD_LANES &lanes, const float *input
+      , const size_t &size, float *output)
+  {
+    const __m128 b0[2] = {_mm_load_ps(lanes.b0), _mm_load_ps(lanes.b0 + 4)};
+    const __m128 b1[2] = {_mm_load_ps(lanes.b1), _mm_load_ps(lanes.b1 + 4)};
+    const __m128 b2[2] = {_mm_load_ps(lanes.b2), _mm_load_ps(lanes.b2 + 4)};
+    const __m128 a1[2] = {_mm_load_ps(lanes.a1), _mm_load_ps(lanes.a1 + 4)};
+    const __m128 a2[2] = {_mm_load_ps(lanes.a2), _mm_load_ps(lanes.a2 + 4)};
+    const __m128 gain[2] = {_mm_load_ps(lanes.gain)
+      , _mm_load_ps(lanes.gain + 4)};
+
+    __m128 x1 = _mm_set1_ps(lanes.x1), x2 = _mm_set1_ps(lanes.x2);
+    __m128 y1[2] = {_mm_load_ps(lanes.y1), _mm_load_ps(lanes.y1 + 4)};
+    __m128 y2[2] = {_mm_load_ps(lanes.y2), _mm_load_ps(lanes.y2 + 4)};
+    for(size_t i = 0; i < size; ++i)
+    {
+      const __m128 x = _mm_set1_ps(input[i]);
+      __m128 scaled[2];
+      for(size_t j = 0; j < 2; ++j)
+      {
+        __m128 y = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(
+                  _mm_mul_ps(b0[j], x), _mm_mul_ps(b1[j], x1))
+                , _mm_mul_ps(b2[j], x2)), _mm_mul_ps(a1[j], y1[j]))
+            , _mm_mul_ps(a2[j], y2[j]));
+        y2[j] = y1[j];
+        y1[j] = y;
+        scaled[j] = _mm_mul_ps(y, gain[j]);
+      }
+
+      x2 = x1;
+      x1 = x;
+
+      __m128 half = _mm_add_ps(scaled[0], scaled[1]);
+      __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+      __m128 sum = _mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1));
+      output[i] += _mm_cvtss_f32(sum);
+    }
+
+    lanes.x1 = _mm_cvtss_f32(x1);
+    lanes.x2 = _mm_cvtss_f32(x2);
+    for(size_t j = 0; j < 2; ++j)
+    {
+      _mm_store_ps(lanes.y1 + 4 * j, y1[j]);
+      _mm_store_ps(lanes.y2 + 4 * j, y2[j]);
+    }
+  }
+#endif
+
+#if ARMS_X86
+  ARMS_TARGET_AVX2
+  void biquad_lanes_avx2(BIQUAD_LANES &lanes, const float *input
+      , const size_t &size, float *output)
+  {
+    const __m256 b0 = _mm256_load_ps(lanes.b0);
+    const __m256 b1 = _mm256_load_ps(lanes.b1);
+    const __m256 b2 = _mm256_load_ps(lanes.b2);
+    const __m256 a1 = _mm256_load_ps(lanes.a1);
+    const __m256 a2 = _mm256_load_ps(lanes.a2);
+    const __m256 gain = _mm256_load_ps(lanes.gain);
+
+    __m256 x1 = _mm256_set1_ps(lanes.x1), x2 = _mm256_set1_ps(lanes.x2);
+    __m256 y1 = _mm256_load_ps(lanes.y1), y2 = _mm256_load_ps(lanes.y2);
+    for(size_t i = 0; i < size; ++i)
+    {
+      const __m256 x = _mm256_set1_ps(input[i]);
+      __m256 y = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(b0, x), _mm256_mul_ps(b1, x1))
+              , _mm256_mul_ps(b2, x2)), _mm256_mul_ps(a1, y1))
+          , _mm256_mul_ps(a2, y2));
+      y2 = y1;
+      y1 = y;
+      x2 = x1;
+      x1 = x;
+
+      __m256 scaled = _mm256_mul_ps(y, gain);
+      __m128 half = _mm_add_ps(_mm256_castps256_ps128(scaled)
+          , _mm256_extractf128_ps(scaled, 1));
+      __m128 pairs = _mm_add_ps(half, _mm_movehl_ps(half, half));
+      __m128 sum = _mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1));
+      output[i] += _mm_cvtss_f32(sum);
+    }
+
+    lanes.x1 = _mm256_cvtss_f32(x1);
+    lanes.x2 = _mm256_cvtss_f32(x2);
+    _mm256_store_ps(lanes.y1, y1);
+    _mm256_store_ps(lanes.y2, y2);
+  }
+#endif
+
+  void biquad_lanes(BIQUAD_LANES &lanes, const float *input
+      , const size_t &size, float *output)
+  {
+#if ARMS_X86
+    switch(get_simd_level())
+    {
+      case SL_AVX2:
+        biquad_lanes_avx2(lanes, input, size, output);
+        return;
+  #if ARMS_SSE2
+      case SL_SSE:
+        biquad_lanes_sse(lanes, input, size, output);
+        return;
+  #endif
+      default:
+        break;
+    }
+#endif
+
+    biquad_lanes_scalar(lanes, input, size, output);
+  }
+
+  /*!
+   *  Grows a ring of pending delayed output to hold at least size samples,
+   *  keeping what is waiting in it. The ring is unrolled so it starts at 0.
+   */
+  void reserve_pending(AudioBuffer &pending, size_t &pendingHead
+      , const size_t &size)
+  {
+    if(pending.size() >= size)
+    {
+      return;
+    }
+
+    AudioBuffer grown(FFT::get_power_of_two(size));
+    const float *waiting = pending.data();
+    float *grownSamples = grown.data();
+    for(size_t i = 0; i < pending.size(); ++i)
+    {
+      grownSamples[i] = waiting[(pendingHead + i) & (pending.size() - 1)];
+    }
+    pending = move(grown);
+    pendingHead = 0;
+  }
+
+  /*!
+   *  Moves the next count samples of the pending ring into the output and
+   *  clears them for the output that lands there later
+   */
+  void flush_pending(AudioBuffer &pending, size_t &pendingHead
+      , float *output, const size_t &count)
+  {
+    const size_t mask = pending.size() - 1;
+    float *waiting = pending.data();
+    for(size_t i = 0; i < count; ++i)
+    {
+      float &sample = waiting[(pendingHead + i) & mask];
+      output[i] = sample;
+      sample = 0.f;
+    }
+    pendingHead = (pendingHead + count) & mask;
+  }
+}
+
+void BIQUAD_LANES::reset()
+{
+  x1 = 0.f;
+  x2 = 0.f;
+  for(size_t i = 0; i < LANES; ++i)
+  {
+    y1[i] = 0.f;
+    y2[i] = 0.f;
+  }
+}
+
 Filter::Filter() { }
 
 Filter::~Filter() { }
 
 void Filter::add_coefficent(const COEFFICENT &coefficent)
 {
-  coefficents.push_back(coefficent);
+  taps.add_tap(coefficent.sampleDelay, coefficent.coefficent);
 }
 
-void Filter::apply_filter(CArray<float> &samples)
+void Filter::apply_filter(AudioBuffer &samples)
 {
   size_t size = samples.size();
-  float *input = new float[size];
-
-  for(size_t i = 0; i < size; ++i)
+  if(size == 0)
   {
-    input[i] = samples[i];
+    return;
   }
 
   static_cast<void>(Logger(Logger::L_MSG
         , "Applying flter to a wave file of size: " + to_string(size)));
-  for(size_t i = 0; i < size; ++i)
-  {
-    float output = 0.f;
-    for(COEFFICENT &coefficent : coefficents)
-    {
-      // Done to avoid going past the bounds of the array
-      if(coefficent.sampleDelay > i)
-      {
-        continue;
-      }
 
-      output += coefficent.coefficent * input[i - coefficent.sampleDelay];
-    }
+  // Taps past the end of the samples are dropped so the size stays the same
+  AudioBuffer output(size);
+  taps.prepare();
+  taps.accumulate(samples.data(), size, output.data(), size);
 
-    if(output > 1.f)
+  for(size_t i = 0; i < size; ++i)
+  {
+    if(output.at(i) > 1.f)
     {
       static_cast<void>(Logger(Logger::L_MSG
             , "Error in audio filtering, output above 1.f, output at: " 
-            + to_string(output)));
+            + to_string(output.at(i))));
+      break;
     }
-
-    samples[i] = output;
   }
+
+  samples = move(output);
+}
+
+void Filter::reset()
+{
+  fill(pending.data(), pending.data() + pending.size(), 0.f);
+  pendingHead = 0;
+}
+
+void Filter::process_block(const float *input, float *output
+    , const size_t &count)
+{
+  // Pending has room for the block and the longest delay past it
+  reserve_pending(pending, pendingHead, count + taps.get_max_delay());
+  taps.prepare();
+
+  taps.accumulate_ring(input, count, pending.data(), pending.size()
+      , pendingHead);
+  flush_pending(pending, pendingHead, output, count);
 }
 
 //===========//
@@ -69,13 +295,18 @@ void Filter::apply_filter(CArray<float> &samples)
 BandPass::BandPass(const float &_frequnecy, const float &_quality
     , const float &_samplingRate)
   : samplingRate(_samplingRate), frequency(_frequnecy), quality(_quality) 
-  , gain(1.f) , a0(0.f), b1(0.f), b2(0.f) { }
+  , gain(1.f), a0(0.f), a1(0.f), a2(0.f), b0(0.f), b1(0.f), b2(0.f) { }
 
 BandPass::BandPass(const BandPass &other)
 {
   *this = other;
 }
 
+BandPass::BandPass(BandPass &&other) noexcept
+{
+  *this = move(other);
+}
+
 BandPass::~BandPass() { }
 
 BandPass &BandPass::operator=(const BandPass &other)
@@ -90,12 +321,25 @@ BandPass &BandPass::operator=(const BandPass &other)
   gain = other.gain;
   quality = other.quality;
   a0 = other.a0;
+  a1 = other.a1;
+  a2 = other.a2;
+  b0 = other.b0;
   b1 = other.b1;
   b2 = other.b2;
+  x1 = other.x1;
+  x2 = other.x2;
+  y1 = other.y1;
+  y2 = other.y2;
 
   return *this;
 }
 
+// A band pass only holds its settings and state so moving is copying
+BandPass &BandPass::operator=(BandPass &&other) noexcept
+{
+  return *this = static_cast<const BandPass &>(other);
+}
+
 void BandPass::set_quality(const float &_quality)
 {
   quality = _quality;
@@ -147,6 +391,58 @@ void BandPass::update_values()
   a2 /= a0;
 }
 
+const float &BandPass::get_gain() const
+{
+  return gain;
+}
+
+void BandPass::get_coefficents(float &_b0, float &_b1, float &_b2, float &_a1
+    , float &_a2) const
+{
+  _b0 = b0;
+  _b1 = b1;
+  _b2 = b2;
+  _a1 = a1;
+  _a2 = a2;
+}
+
+/*
+ *  The ringing decays with the radius r of the poles of the band, so it takes
+ *    n = ln(1000) / -ln(r)
+ *  samples to drop by 60 dB
+ */
+size_t BandPass::get_decay_length() const
+{
+  if(samplingRate == 0 || std::isnan(samplingRate) || quality <= 0.f)
+  {
+    return 0;
+  }
+
+  const float PI = 4.f * atan(1);
+  float omega = 2.f * PI * frequency / samplingRate;
+  float alpha = sin(omega) / (2.f * quality);
+  float poleA1 = -2.f * cos(omega) / (1.f + alpha);
+  float poleA2 = (1.f - alpha) / (1.f + alpha);
+
+  // Complex poles share the radius sqrt(a2), real poles decay at the rate of
+  // the larger one
+  float discriminant = poleA1 * poleA1 - 4.f * poleA2;
+  float radius = (discriminant < 0.f) ? sqrt(poleA2)
+    : (abs(poleA1) + sqrt(discriminant)) / 2.f;
+  if(radius <= 0.f)
+  {
+    return 0;
+  }
+  if(radius >= 1.f)
+  {
+    static_cast<void>(Logger(Logger::L_WRN
+          , "BandPass doesn't decay at frequency: " + to_string(frequency)));
+    return static_cast<size_t>(samplingRate);
+  }
+
+  return static_cast<size_t>(ceil(6.908f / -log(radius)));
+}
+
 bool BandPass::is_valid() const
 {
   if(frequency == 0 || samplingRate == 0)
@@ -163,20 +459,44 @@ const float &BandPass::get_sampling_rate() const
 }
 
 // Biquad band-pass filter
-void BandPass::apply_filter(CArray<float> &samples)
+void BandPass::apply_filter(AudioBuffer &samples)
+{
+  if(samples.size() == 0)
+  {
+    return;
+  }
+
+  reset();
+  process_block(samples.data(), samples.data(), samples.size());
+}
+
+void BandPass::reset()
+{
+  x1 = 0.f;
+  x2 = 0.f;
+  y1 = 0.f;
+  y2 = 0.f;
+}
+
+void BandPass::process_block(const float *input, float *output
+    , const size_t &count)
 {
   if(samplingRate == 0)
   {
     static_cast<void>(Logger(Logger::L_ERR, "Invalid sampling rate of: 0"));
+    if(output != input)
+    {
+      copy(input, input + count, output);
+    }
     return;
   }
 
   update_values();
 
-  float x = 0.f, y = 0.f, x1 = 0.f, y1 = 0.f, x2 = 0.f, y2 = 0.f;
-  for(size_t i = 0; i < samples.size(); ++i)
+  float x = 0.f, y = 0.f;
+  for(size_t i = 0; i < count; ++i)
   {
-    x = samples[i];
+    x = input[i];
 
     y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
 
@@ -185,7 +505,7 @@ void BandPass::apply_filter(CArray<float> &samples)
     y2 = y1;
     y1 = y;
 
-    samples[i] = y * gain;
+    output[i] = y * gain;
   }
 }
 
@@ -206,6 +526,11 @@ Equalizer::Equalizer(const Equalizer &other)
   *this = other;
 }
 
+Equalizer::Equalizer(Equalizer &&other) noexcept
+{
+  *this = move(other);
+}
+
 Equalizer::~Equalizer() { }
 
 Equalizer &Equalizer::operator=(const Equalizer &other)
@@ -226,6 +551,31 @@ Equalizer &Equalizer::operator=(const Equalizer &other)
     bands[i] = other.bands.at(i);
   }
 
+  laneGroups = other.laneGroups;
+  delayLine = other.delayLine;
+  delayHead = other.delayHead;
+
+  return *this;
+}
+
+Equalizer &Equalizer::operator=(Equalizer &&other) noexcept
+{
+  if(this == &other)
+  {
+    return *this;
+  }
+
+  bandMax = other.bandMax;
+  delay = other.delay;
+  quality = other.quality;
+  samplingRate = other.samplingRate;
+
+  bands = move(other.bands);
+  laneGroups = move(other.laneGroups);
+  delayLine = move(other.delayLine);
+  delayHead = other.delayHead;
+  work = move(other.work);
+
   return *this;
 }
 
@@ -236,6 +586,11 @@ void Equalizer::calculate_quality(const uint8_t &quanity)
   quality = pow(10.f, delta / 2.f) / (pow(10.f, delta) - 1);
 }
 
+const float &Equalizer::get_quality() const
+{
+  return quality;
+}
+
 void Equalizer::add_coefficent(const float &frequency, const float &coefficent
         , const size_t &band)
 {
@@ -259,7 +614,7 @@ void Equalizer::add_coefficent(const float &frequency, const float &coefficent
   bands[band].set_sampling_rate(samplingRate);
 }
 
-void Equalizer::apply_filter(CArray<float> &samples)
+void Equalizer::apply_filter(AudioBuffer &samples)
 {
   // Check bands for invalid bands
   /*
@@ -273,28 +628,452 @@ void Equalizer::apply_filter(CArray<float> &samples)
   }
   */
 
-  // Apply filter of all bands 
-  CArray<float> returnArray;
-  returnArray.resize(samples.size() + static_cast<size_t>(delay));
-  for(size_t i = 0; i < returnArray.size(); ++i)
+  const size_t size = samples.size();
+  const size_t delaySamples = static_cast<size_t>(delay);
+  if(size == 0)
+  {
+    samples = AudioBuffer(delaySamples);
+    return;
+  }
+
+  // The output is long enough for the slowest band to ring out
+  size_t decayLength = 0;
+  for(size_t i = 0; i < bands.size(); ++i)
+  {
+    decayLength = max(decayLength, bands.at(i).get_decay_length());
+  }
+  AudioBuffer returnArray(size + delaySamples + decayLength);
+
+  // The whole signal is in memory so the bands are added straight into the
+  // delayed output rather than going through the delay line
+  reset();
+  run_bands(samples.data(), size, returnArray.data() + delaySamples);
+  if(decayLength > 0)
+  {
+    // The bands ring out on silence
+    work.resize_uninitialized(decayLength);
+    fill(work.data(), work.data() + decayLength, 0.f);
+    run_bands(work.data(), decayLength
+        , returnArray.data() + delaySamples + size);
+  }
+
+  // Override with new output based on input
+  samples = move(returnArray);
+}
+
+void Equalizer::reset()
+{
+  for(BIQUAD_LANES &lanes : laneGroups)
+  {
+    lanes.reset();
+  }
+  fill(delayLine.data(), delayLine.data() + delayLine.size(), 0.f);
+  delayHead = 0;
+}
+
+void Equalizer::process_block(const float *input, float *output
+    , const size_t &count)
+{
+  // The bands are added into work so it starts silent
+  work.resize_uninitialized(count);
+  float *bandOutput = work.data();
+  fill(bandOutput, bandOutput + count, 0.f);
+  run_bands(input, count, bandOutput);
+
+  const size_t delaySamples = static_cast<size_t>(delay);
+  if(delaySamples == 0)
+  {
+    copy(bandOutput, bandOutput + count, output);
+    return;
+  }
+
+  if(delayLine.size() != delaySamples)
+  {
+    delayLine.resize_uninitialized(delaySamples);
+    fill(delayLine.data(), delayLine.data() + delaySamples, 0.f);
+    delayHead = 0;
+  }
+
+  float *delayed = delayLine.data();
+  for(size_t i = 0; i < count; ++i)
   {
-    returnArray[i] = 0.f;
+    output[i] = delayed[delayHead];
+    delayed[delayHead] = bandOutput[i];
+    delayHead = (delayHead + 1 == delaySamples) ? 0 : delayHead + 1;
+  }
+}
+
+void Equalizer::run_bands(const float *input, const size_t &count
+    , float *output)
+{
+  // Every band reads the same input so up to 8 bands are run at once, each
+  // in its own lane, and summed straight into the output
+  const size_t LANES = BIQUAD_LANES::LANES;
+  laneGroups.resize((bands.size() + LANES - 1) / LANES);
+  for(size_t group = 0; group < laneGroups.size(); ++group)
+  {
+    // The coefficents are refreshed every block in case a band changed, the
+    // state carries on from the last block
+    BIQUAD_LANES &lanes = laneGroups[group];
+    const size_t first = group * LANES;
+    for(size_t j = 0; j < LANES; ++j)
+    {
+      lanes.b0[j] = lanes.b1[j] = lanes.b2[j] = 0.f;
+      lanes.a1[j] = lanes.a2[j] = lanes.gain[j] = 0.f;
+      if(first + j >= bands.size())
+      {
+        continue;
+      }
+
+      BandPass &band = bands[first + j];
+      if(band.get_sampling_rate() == 0)
+      {
+        // Bands that were never set leave the input as is
+        lanes.b0[j] = 1.f;
+        lanes.gain[j] = 1.f;
+        continue;
+      }
+
+      band.update_values();
+      band.get_coefficents(lanes.b0[j], lanes.b1[j], lanes.b2[j]
+          , lanes.a1[j], lanes.a2[j]);
+      lanes.gain[j] = band.get_gain();
+    }
+
+    biquad_lanes(lanes, input, count, output);
   }
+}
+
+//=============//
+// Filter Bank //
+//=============//
+
+FilterBank::FilterBank(const uint8_t &bandCount, const float &_samplingRate)
+  : samplingRate(_samplingRate)
+{
+  // Matches the quality an Equalizer gives the same number of bands
+  float quality = Equalizer(bandCount, samplingRate).get_quality();
 
+  bands.resize(bandCount);
   for(size_t i = 0; i < bands.size(); ++i)
   {
-    CArray<float> output(samples);
-    // 0Hz bands are left to help normalize audio and removed unwanted
-    // distortion
-    bands[i].apply_filter(output);
+    bands[i] = BandPass(0.f, quality, samplingRate);
+  }
+  taps.resize(bandCount);
+}
+
+FilterBank::~FilterBank() { }
+
+void FilterBank::set_frequency(const size_t &band, const float &frequency)
+{
+  if(band >= bands.size())
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Invalid band set in FilterBank at index: " + to_string(band)));
+    return;
+  }
+
+  bands[band].set_frequency(frequency);
+}
+
+void FilterBank::add_tap(const unsigned &delay, const float *gains)
+{
+  for(size_t i = 0; i < taps.size(); ++i)
+  {
+    taps[i].add_tap(delay, gains[i]);
+  }
+}
+
+size_t FilterBank::get_band_count() const
+{
+  return bands.size();
+}
+
+void FilterBank::clear()
+{
+  bands.clear();
+  taps.clear();
+  pending.clear();
+  pendingHead = 0;
+}
+
+void FilterBank::apply_filter(AudioBuffer &samples)
+{
+  const size_t size = samples.size();
+  if(size == 0)
+  {
+    return;
+  }
+
+  // Both buffers are allocated once at their final length, each band rings
+  // out past the input and every tap of it is mixed into the output
+  const size_t bandLength = size + get_tail_length() - get_max_delay();
+  AudioBuffer output(size + get_tail_length());
+  AudioBuffer split;
+  split.resize_uninitialized(bandLength);
+  float *splitSamples = split.data();
+
+  static_cast<void>(Logger(Logger::L_MSG, "Mixing " + to_string(size)
+        + " samples through " + to_string(bands.size()) + " bands"));
+  prepare_taps();
+
+  for(size_t i = 0; i < bands.size(); ++i)
+  {
+    // The band is split from the input once and shared by every tap
+    copy(samples.front(), samples.front() + size, splitSamples);
+    fill(splitSamples + size, splitSamples + bandLength, 0.f);
+    bands[i].reset();
+    bands[i].process_block(splitSamples, splitSamples, bandLength);
+    taps[i].accumulate(splitSamples, bandLength, output.data()
+        , output.size());
+  }
+
+  samples = move(output);
+}
+
+void FilterBank::reset()
+{
+  for(size_t i = 0; i < bands.size(); ++i)
+  {
+    bands[i].reset();
+  }
+  fill(pending.data(), pending.data() + pending.size(), 0.f);
+  pendingHead = 0;
+}
+
+void FilterBank::process_block(const float *input, float *output
+    , const size_t &count)
+{
+  // Pending has room for the block and the longest delay past it
+  reserve_pending(pending, pendingHead, count + get_max_delay());
+  prepare_taps();
+
+  // Every band writes the whole block before it is read
+  band.resize_uninitialized(count);
+  for(size_t i = 0; i < bands.size(); ++i)
+  {
+    bands[i].process_block(input, band.data(), count);
+    taps[i].accumulate_ring(band.data(), count, pending.data()
+        , pending.size(), pendingHead);
+  }
+
+  flush_pending(pending, pendingHead, output, count);
+}
+
+void FilterBank::prepare_taps()
+{
+  for(MultiTapDelay &bandTaps : taps)
+  {
+    bandTaps.prepare();
+  }
+}
+
+size_t FilterBank::get_tail_length() const
+{
+  size_t decayLength = 0;
+  for(size_t i = 0; i < bands.size(); ++i)
+  {
+    decayLength = max(decayLength, bands.at(i).get_decay_length());
+  }
+
+  return get_max_delay() + decayLength;
+}
+
+unsigned FilterBank::get_max_delay() const
+{
+  unsigned maxDelay = 0u;
+  for(const MultiTapDelay &bandTaps : taps)
+  {
+    maxDelay = max(maxDelay, bandTaps.get_max_delay());
+  }
+
+  return maxDelay;
+}
+
+//===========//
+// Convolver //
+//===========//
+
+Convolver::Convolver() { }
+
+Convolver::~Convolver() { }
+
+void Convolver::set_impulse_response(const AudioBuffer &response)
+{
+  impulseResponse = response;
+  engine = UniformConvolver();
+  pending.clear();
+  pendingHead = 0;
+
+  size_t length = impulseResponse.size();
+  if(length <= DIRECT_LENGTH)
+  {
+    return;
+  }
+
+  // Short responses fit in a single block
+  engine.set_impulse_response(impulseResponse.front(), length
+      , min(FFT::get_power_of_two(length), MAX_BLOCK_SIZE));
+}
 
-    // Apply delay
-    // TODO: May need to look at this :)
-    for(size_t j = 0; j < output.size(); ++j)
+size_t Convolver::get_length() const
+{
+  return impulseResponse.size();
+}
+
+const AudioBuffer &Convolver::get_impulse_response() const
+{
+  return impulseResponse;
+}
+
+size_t Convolver::get_block_size() const
+{
+  return engine.is_valid() ? engine.get_block_size() : 1;
+}
+
+void Convolver::apply_filter(AudioBuffer &samples)
+{
+  size_t size = samples.size();
+  size_t length = impulseResponse.size();
+  if(size == 0 || length == 0)
+  {
+    return;
+  }
+
+  static_cast<void>(Logger(Logger::L_MSG
+        , "Convolving a wave file of size: " + to_string(size)
+        + " with an impulse response of size: " + to_string(length)));
+
+  // Only the direct convolution adds into its output, the partitioned one
+  // writes every sample so its output isn't zeroed first
+  AudioBuffer output;
+  if(!engine.is_valid())
+  {
+    output.resize(size + length - 1);
+    apply_direct(samples, output);
+  }
+  else
+  {
+    output.resize_uninitialized(size + length - 1);
+    apply_partitioned(samples, output);
+  }
+
+  samples = move(output);
+}
+
+void Convolver::reset()
+{
+  engine.reset();
+  fill(pending.data(), pending.data() + pending.size(), 0.f);
+  pendingHead = 0;
+}
+
+void Convolver::process_block(const float *input, float *output
+    , const size_t &count)
+{
+  size_t length = impulseResponse.size();
+  if(length == 0)
+  {
+    fill(output, output + count, 0.f);
+    return;
+  }
+
+  if(engine.is_valid())
+  {
+    const size_t blockSize = engine.get_block_size();
+    if(count % blockSize != 0)
     {
-      returnArray[j+static_cast<size_t>(delay)] += output[j];
+      static_cast<void>(Logger(Logger::L_ERR, "Convolver blocks must be a "
+            + string("multiple of ") + to_string(blockSize) + " samples, got: "
+            + to_string(count)));
+      // Silence rather than passing the dry input through as if it were
+      // convolved
+      fill(output, output + count, 0.f);
+      return;
     }
+
+    for(size_t begin = 0; begin < count; begin += blockSize)
+    {
+      engine.process_block(input + begin, output + begin);
+    }
+    return;
+  }
+
+  // Short responses add their whole response for each sample, the part past
+  // the block waits in pending
+  reserve_pending(pending, pendingHead, count + length - 1);
+
+  const float *response = impulseResponse.front();
+  const size_t ringSize = pending.size();
+  float *ring = pending.data();
+  for(size_t i = 0; i < count; ++i)
+  {
+    // The response is split where it wraps around the ring
+    const float sample = input[i];
+    const size_t begin = (pendingHead + i) & (ringSize - 1);
+    const size_t first = min(length, ringSize - begin);
+    float *tail = ring + begin;
+    for(size_t j = 0; j < first; ++j)
+    {
+      tail[j] += sample * response[j];
+    }
+    for(size_t j = first; j < length; ++j)
+    {
+      ring[j - first] += sample * response[j];
+    }
+  }
+
+  flush_pending(pending, pendingHead, output, count);
+}
+
+void Convolver::apply_direct(const AudioBuffer &samples
+    , AudioBuffer &output) const
+{
+  size_t size = samples.size();
+  size_t length = impulseResponse.size();
+  const float *input = samples.front();
+  const float *response = impulseResponse.front();
+  float *outputSamples = output.data();
+  for(size_t i = 0; i < size; ++i)
+  {
+    const float sample = input[i];
+    if(sample == 0.f)
+    {
+      continue;
+    }
+
+    // Add the whole response scaled by the sample, this inner loop is
+    // contiguous so the compiler can vectorize it
+    float *tail = outputSamples + i;
+    for(size_t j = 0; j < length; ++j)
+    {
+      tail[j] += sample * response[j];
+    }
+  }
+}
+
+void Convolver::apply_partitioned(const AudioBuffer &samples
+    , AudioBuffer &output)
+{
+  const size_t size = samples.size();
+  const size_t outputSize = output.size();
+  const size_t blockSize = engine.get_block_size();
+
+  engine.reset();
+
+  // Blocks past the end of the input are silent and flush out the tail
+  const float *input = samples.front();
+  float *outputSamples = output.data();
+  vector<float> block(blockSize);
+  for(size_t begin = 0; begin < outputSize; begin += blockSize)
+  {
+    size_t count = (begin < size) ? min(blockSize, size - begin) : 0;
+    copy(input + begin, input + begin + count, block.begin());
+    fill(block.begin() + count, block.end(), 0.f);
+
+    engine.process_block(block.data(), block.data());
+
+    copy(block.begin(), block.begin() + min(blockSize, outputSize - begin)
+        , outputSamples + begin);
   }
-  // Override with new output based on input
-  samples = returnArray;
 }
@@ -9,8 +9,11 @@
 
 #include "generator.h"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <string>
+#include <thread>
 
 #include "source.h"
 #include "listener2.h"
@@ -20,16 +23,17 @@
 
 #include "arms_math.h"
 #include "helper.h"
+#include "intersect.h"
 
 using namespace std;
 
-const size_t NULL_LINES = 99;
-const CArray<Vec2> DEFAULT_AMP;
+const CoefficentArray DEFAULT_AMP;
 
 struct ListenerData
 {
   string pattern;
   float angle;
+  string receiver;
 };
 
 struct SourceData
@@ -38,6 +42,8 @@ struct SourceData
   float cone;
   int checks;
   int rays;
+  float threshold;
+  bool roulette;
 };
 
 Vec4 get_room_size(DataMap *dataMap)
@@ -94,7 +100,7 @@ array<Vec2, 2> get_object_data(DataMap::DataMapIterator it)
 
 ListenerData get_listener_data(DataMap::DataMapIterator it)
 {
-  ListenerData data = {"Omni", 0.f};
+  ListenerData data = {"Omni", 0.f, "box"};
 
   for(DataMap::DataMapIterator childIt = (*it)->get_children_begin()
         ; childIt != (*it)->get_children_end(); ++childIt)
@@ -107,6 +113,10 @@ ListenerData get_listener_data(DataMap::DataMapIterator it)
     {
       data.angle = *(*childIt)->get_casted_data<int>();
     }
+    else if((*childIt)->get_name() == "Receiver")
+    {
+      data.receiver = *(*childIt)->get_casted_data<string>();
+    }
   }
 
   return data;
@@ -114,7 +124,7 @@ ListenerData get_listener_data(DataMap::DataMapIterator it)
 
 SourceData get_source_data(DataMap::DataMapIterator it)
 {
-  SourceData data = {0.f, 30.f, 10, 30};
+  SourceData data = {0.f, 30.f, 10, 30, 0.f, false};
 
   for(DataMap::DataMapIterator childIt = (*it)->get_children_begin()
         ; childIt != (*it)->get_children_end(); ++childIt)
@@ -135,6 +145,15 @@ SourceData get_source_data(DataMap::DataMapIterator it)
     {
       data.rays = *(*childIt)->get_casted_data<int>();
     }
+    else if((*childIt)->get_name() == "Threshold")
+    {
+      // The floor is always below the starting energy, so -60 and 60 match
+      data.threshold = -abs(*(*childIt)->get_casted_data<int>());
+    }
+    else if((*childIt)->get_name() == "Roulette")
+    {
+      data.roulette = *(*childIt)->get_casted_data<int>() != 0;
+    }
   }
 
   return data;
@@ -211,7 +230,7 @@ vector<Object *> convert_DataMap_to_Object(DataMap *dataMap
 
       objVec.push_back(new Source(objData[0] * scalar + posOffset 
             , objData[1] * scalar, data.direction, data.cone
-            , data.checks, data.rays));
+            , data.checks, data.rays, data.threshold, data.roulette));
     }
     else if((*it)->get_name() == "Listener")
     {
@@ -219,7 +238,7 @@ vector<Object *> convert_DataMap_to_Object(DataMap *dataMap
       ListenerData data = get_listener_data(it);
 
       objVec.push_back(new Listener(objData[0] * scalar + posOffset 
-            , objData[1] * scalar, data.angle, data.pattern));
+            , objData[1] * scalar, data.angle, data.pattern, data.receiver));
     }
     else if((*it)->get_name() == "Barrier")
     {
@@ -241,163 +260,275 @@ Vec2 get_object_center(Object *obj)
   return position + size / 2.f;
 }
 
+/*!
+ *  \struct RayTermination
+ *
+ *  \brief
+ *    When a traced ray stops bouncing
+ */
+struct RayTermination
+{
+  // The number of bounces a ray may take before it is considered dead
+  int maxChecks;
+  // The energy, as a fraction of the starting energy, a ray is considered
+  // inaudible below. 0 never stops a ray early.
+  float energyFloor;
+  // Inaudible rays survive with a chance in proportion to their energy and
+  // are boosted to make up for the rays stopped, keeping the average energy
+  bool roulette;
+};
+
+/*!
+ *  \struct TraceRay
+ *
+ *  \brief
+ *    The state of a ray while its path is traced. A worker reuses the same
+ *    rays for every path it traces so their buffers stop allocating once
+ *    they have grown to the longest path.
+ */
+struct TraceRay
+{
+  /*!
+   *  Starts tracing a new path from the source
+   *
+   *  \param _begin
+   *    The position of the source
+   *  \param _end
+   *    The far end of the inital ray
+   *  \param index
+   *    The index of the inital ray, seeding the ray's random numbers so a
+   *    path never depends on how the rays were split between workers
+   */
+  void start(const Vec2 &_begin, const Vec2 &_end, const size_t &index)
+  {
+    begin = _begin;
+    end = _end;
+    collision = CollisionInfo();
+    checks = 0;
+    distance = 0.f;
+    // Hash the index so neighbouring rays don't start with similar states
+    random = static_cast<uint32_t>(index) * 0x9E3779B9u + 0x7F4A7C15u;
+    random ^= random >> 16;
+    random = (random == 0u) ? 1u : random;
+    energy.fill(1.f);
+    points.clear();
+    points.push_back(_begin);
+    levels.clear();
+  }
+
+  // The segment being traced
+  Vec2 begin;
+  Vec2 end;
+  // The last collision, its edge is ignored by the next check
+  CollisionInfo collision;
+  int checks = 0;
+  // The distance travelled before the current segment in centimeters, only
+  // tracked for volumetric receivers
+  float distance = 0.f;
+  // The energy of each band of the scene's grid the ray carries
+  BandEnergy energy;
+  // The reflection points of the path and the energy of each segment
+  vector<Vec2> points;
+  vector<float> levels;
+  // State of the ray's xorshift random numbers, never 0
+  uint32_t random = 1u;
+
+  /*!
+   *  \returns
+   *    The next random number of the ray in [0, 1)
+   */
+  float next_random()
+  {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return static_cast<float>(random >> 8) / 16777216.f;
+  }
+};
+
+/*!
+ *  Applies a found collision to a ray, ending its segment at the collision
+ *  point and adding the point to its path
+ *
+ *  \param table
+ *    The compiled edges of the scene
+ *  \param receiver
+ *    The volumetric receiver the segment may pass through, if any
+ *  \param histogram
+ *    The histogram of the volumetric receiver
+ *  \param ray
+ *    The ray that collided
+ *  \param closestEdge
+ *    The edge that was hit
+ *  \param newRayEnd
+ *    The point of the collision
+ */
+void apply_collision(const EdgeTable &table, const VolumeReceiver *receiver
+    , EnergyHistogram &histogram, TraceRay &ray, const uint32_t &closestEdge
+    , const Vec2 &newRayEnd)
+{
+  ray.collision = CollisionInfo(true, closestEdge);
+
+  if(receiver)
+  {
+    ray.distance += receiver->add_segment(ray.begin, newRayEnd, ray.distance
+        , ray.energy, histogram);
+  }
+
+  // Check if a listener was hit.
+  // If it is exit (THIS IS WHAT WE ARE WAITING FOR!!!)
+  // NOTE: Nothing is logged here as every worker would serialise on the
+  // output, the hits are counted once the workers are merged
+  if(table.get_kind(closestEdge) == EdgeTable::EK_LISTENER)
+  {
+    float gain = table.get_listener(closestEdge)->get_directional_gain(
+        {ray.begin.x - newRayEnd.x, ray.begin.y - newRayEnd.y});
+    ray.energy *= gain;
+  }
+
+  ray.end = newRayEnd;
+  ray.points.push_back(newRayEnd);
+  ray.levels.push_back(ray.energy.average(table.get_band_count()));
+}
+
 /*!
  *  Detect if a collision occured on the calculated trajectory of the line.
  *
  *  TODO: Have a cone for the listener for collision detection
  *  in parallel maybe move the cone for src to the source object
  *  
- *  \param objVec
- *    A vector of all objects in the scene
- *  \param rayBegin
- *    A position of where the ray begins
- *  \param rayEnd
- *    A reference to the end position of the ray which will be updated to
- *    represent the collision point if a collision occurs
- *  
- *  \returns
- *    Returns a struct of collision info
+ *  \param table
+ *    The compiled edges of the scene
+ *  \param grid
+ *    The collision grid of the scene, if nullptr every edge in the table is
+ *    checked instead (brute force)
+ *  \param receiver
+ *    The volumetric receiver of the scene, if any
+ *  \param histogram
+ *    The histogram of the volumetric receiver
+ *  \param ray
+ *    The ray being checked, its segment will end at the collision point and
+ *    its collision is updated
  */
-const CollisionInfo detect_collisions(vector<Object *> &objVec
-    , AudioRay *ray)
+void detect_collisions(const EdgeTable &table, const CollisionGrid *grid
+    , const VolumeReceiver *receiver, EnergyHistogram &histogram
+    , TraceRay &ray)
 {
-  CollisionInfo info;
-  float intersectionDistance = -1.f;
-  Vec2 rayBegin = ray->get_posA();
-  Vec2 rayEnd = ray->get_posB();
   Vec2 newRayEnd(0.f, 0.f);
+  uint32_t closestEdge = EdgeTable::NO_EDGE;
 
-  for(Object *obj : objVec)
+  if(grid)
   {
-    // NOTE: Currently ignoring source for collisions as rays start in middle of
-    // source box, SOON NULL_LINES WILL BE USED MAYBE
-    if(obj->get_type_name() == "Source")
+    closestEdge = grid->find_closest_edge(ray.begin, ray.end
+        , ray.collision.edge, newRayEnd);
+  }
+  else
+  {
+    // Line-Line collision done for every edge in the scene
+    EdgeSpan span{table.beginX.data(), table.beginY.data()
+      , table.endX.data(), table.endY.data(), nullptr, 0u, table.size()};
+    EdgeHit closest;
+    // DO NOT CHECK PARENT AT REFLECTION LINE AS THIS WILL
+    // CAUSE COLLISION ERRORS
+    intersect_edges(span, ray.begin, ray.end, ray.collision.edge, closest);
+
+    if(closest.is_hit())
     {
-      continue;
+      newRayEnd = ray.begin + ((ray.end - ray.begin) * closest.u);
+      closestEdge = closest.edge;
     }
+  }
 
-    Vec2 objPos = obj->get_position();
-    Vec2 objSize = obj->get_size();
-    std::array<Vec2, 4> objLines = 
-    {
-      Vec2{obj->get_position()},
-      Vec2{objPos.x + objSize.x, objPos.y},
-      Vec2{objPos.x + objSize.x, objPos.y + objSize.y},
-      Vec2{objPos.x, objPos.y + objSize.y}
-    };
-    
-    // Line-Line collision done for each wall of the barrier
-    for(int i = 0; i < 4; ++i)
-    {
-      // DO NOT CHECK PARENT AT REFLECTION LINE AS THIS WILL 
-      // CAUSE COLLISION ERRORS
-      if(ray->get_parent() == obj && ray->get_parent_line() == i)
-      {
-        continue;
-      }
+  if(closestEdge == EdgeTable::NO_EDGE)
+  {
+    ray.collision = CollisionInfo();
+    return;
+  }
 
-      int nextPoint = (i + 1) % 4;
-      float denominator = 
-        (
-          (objLines[nextPoint].y - objLines[i].y) * (rayEnd.x - rayBegin.x) 
-          - (objLines[nextPoint].x - objLines[i].x) * (rayEnd.y - rayBegin.y)
-        );
-      
-      // Ignore parallel lines
-      if(denominator == 0)
-      {
-        continue;
-      }
+  apply_collision(table, receiver, histogram, ray, closestEdge, newRayEnd);
+}
 
-      // Normalized points of intersection
-      float uA = 
-        (
-          (objLines[nextPoint].x - objLines[i].x) * (rayBegin.y - objLines[i].y) 
-          - (objLines[nextPoint].y - objLines[i].y) * (rayBegin.x - objLines[i].x)
-        ) / denominator;
-      float uB = 
-        (
-          (rayEnd.x - rayBegin.x) * (rayBegin.y - objLines[i].y) 
-          - (rayEnd.y - rayBegin.y) * (rayBegin.x - objLines[i].x)
-        ) / denominator;
-
-      if(uA >= 0 && uA <= 1 && uB >= 0 && uB <= 1)
-      {
-        // Calculate intersection
-        Vec2 intersectionPos = rayBegin + ((rayEnd - rayBegin) * uA);
-        float distance = (intersectionPos - rayBegin).magnitude();
+/*!
+ *  Checks if a ray that hit a barrier should keep bouncing. The barrier's
+ *  material is absorbed first so the check sees the energy the ray leaves
+ *  the hit with.
+ *
+ *  \param table
+ *    The compiled edges of the scene
+ *  \param ray
+ *    The ray being checked, absorbed by the barrier it hit and with roulette
+ *    a surviving ray's energy is boosted
+ *  \param termination
+ *    When rays stop bouncing
+ *
+ *  \returns
+ *    If the ray should reflect and be traced further
+ */
+bool continue_trace_ray(const EdgeTable &table, TraceRay &ray
+    , const RayTermination &termination)
+{
+  if(ray.checks >= termination.maxChecks || !ray.collision.collision
+      || table.get_kind(ray.collision.edge) == EdgeTable::EK_LISTENER)
+  {
+    return false;
+  }
 
-        // Only update if closer intersection
-        if(intersectionDistance > 0 && distance >= intersectionDistance)
-        {
-          continue;
-        }
-      
-        intersectionDistance = distance;
-        newRayEnd = intersectionPos;
-        info.collision = true;
-        info.parent = obj;
-        info.parentLine = i;
-        info.lineBegin = objLines[i];
-        info.lineEnd = objLines[nextPoint];
+  // Absorb the energy of the barrier's material
+  // NOTE: This currently can only be a barrier as sources are ignored in
+  // detection and listeners are handled above
+  ray.energy *= table.get_material(ray.collision.edge);
 
-      }
-    }
+  if(termination.energyFloor <= 0.f)
+  {
+    return true;
+  }
 
-    // Check if parent exists and then check if a listener.
-    // If it is exit (THIS IS WHAT WE ARE WAITING FOR!!!)
-    if(info.parent && info.parent->get_type_name() == "Listener")
-    {
-      static_cast<void>(Logger(Logger::L_MSG, "Listener Hit!"));
-      float gain = dynamic_cast<Listener*>(info.parent)->get_directional_gain(
-          {rayBegin.x - newRayEnd.x, rayBegin.y - newRayEnd.y});
-      ray->scale_amp(gain);
-      for(size_t i = 0; i < ray->get_amp().size(); ++i)
-      {
-        Logger(Logger::L_MSG, "Listener gain " 
-              + to_string(ray->get_amp().at(i).x)
-              + "Hz: " 
-              + to_string(ray->get_amp().at(i).y));
-      }
-      break;
-    }
+  // A ray is audible while any of its bands is
+  float loudest = 0.f;
+  for(size_t i = 0; i < table.get_band_count(); ++i)
+  {
+    loudest = max(loudest, ray.energy[i]);
   }
 
-  if(!info.collision)
+  if(loudest >= termination.energyFloor)
   {
-    return info;
+    return true;
   }
 
-  // Log Collision
-  string collisionMsg = "Collision detected at: ( "
-    + std::to_string(newRayEnd.x) + " , "
-    + std::to_string(newRayEnd.y) + " )";
-  //static_cast<void>(Logger(Logger::L_MSG, collisionMsg));
-  
-  ray->set_posB(newRayEnd);
-  return info;
+  if(!termination.roulette || loudest <= 0.f)
+  {
+    return false;
+  }
+
+  float survival = loudest / termination.energyFloor;
+  if(ray.next_random() >= survival)
+  {
+    return false;
+  }
+
+  ray.energy *= 1.f / survival;
+  return true;
 }
 
-AudioRay *resolve_collision(AudioRay *ray, const CollisionInfo &info
+/*!
+ *  Reflects a ray off of the edge it collided with, starting its next
+ *  segment at the collision point. The barrier's material has already been
+ *  absorbed by continue_trace_ray.
+ */
+void resolve_collision(TraceRay &ray, const EdgeTable &table
     , const Vec2 &scalar)
 {
-  Vec2 posA = ray->get_posA();
-  Vec2 posB = ray->get_posB();
-  CArray<Vec2> amp = ray->get_amp();
+  const CollisionInfo &info = ray.collision;
+  Vec2 posA = ray.begin;
+  Vec2 posB = ray.end;
 
-  // Override amp with new added barrier amp if parent is a barrier
-  // NOTE: This currently can only be a barrier as sources are ignored in
-  // detection and listeners are handled before resolution seperatly
-  amp = ray->add_amps(info.parent->get_absortion_coefficent());
-  
   Vec2 incidentVec = posB - posA;
 
   // Transform the incident Vec into physical space based on scene size
   Vec2 phyIncident = incidentVec / scalar;
 
-  Vec2 lineDirection = info.lineEnd / scalar - info.lineBegin / scalar;
-  Vec2 normalVec(-lineDirection.y, lineDirection.x);
-  normalVec.normalize();
+  // The normal is precomputed in physical space when the table is compiled
+  Vec2 normalVec = table.get_normal(info.edge);
 
   Vec2 reflectedVec = phyIncident 
     - normalVec * 2.f * phyIncident.dot(normalVec);
@@ -406,11 +537,16 @@ AudioRay *resolve_collision(AudioRay *ray, const CollisionInfo &info
   scaledReflection.normalize();
   Vec2 posC = posB + scaledReflection * DEFAULT_RAY_DISTANCE;
 
-  return new AudioRay(info.parent, info.parentLine, amp, posB, posC);
+  ray.begin = posB;
+  ray.end = posC;
+  ++ray.checks;
 }
 
-vector<vector<AudioRay *>> generate_inital_audio_rays(Object *parent
-    , const Vec2 &srcPos)
+/*!
+ *  Gets the far end of every inital ray, evenly spaced across the source's
+ *  cone
+ */
+vector<Vec2> generate_inital_audio_rays(Object *parent)
 {
   Source *source = dynamic_cast<Source*>(parent);
 
@@ -424,7 +560,8 @@ vector<vector<AudioRay *>> generate_inital_audio_rays(Object *parent
   const float degreeIncrement = coneSize 
     / static_cast<float>(source->get_rays());
 
-  vector<vector<AudioRay *>> returnVec;
+  vector<Vec2> returnVec;
+  returnVec.reserve(source->get_rays());
 
   float currentDegree = direction - coneSize / 2.f;
   for(int i = 0; i < source->get_rays(); ++i)
@@ -432,10 +569,7 @@ vector<vector<AudioRay *>> generate_inital_audio_rays(Object *parent
     Vec2 endPos = Vec2{cos(currentDegree), sin(currentDegree)} 
       * DEFAULT_RAY_DISTANCE;
     currentDegree += degreeIncrement;
-    vector<AudioRay *> newVec;
-    newVec.push_back(new AudioRay(parent, NULL_LINES, DEFAULT_AMP, srcPos
-          , endPos));
-    returnVec.push_back(newVec);
+    returnVec.push_back(endPos);
   }
 
   return returnVec;
@@ -463,7 +597,7 @@ vector<vector<AudioRay *>> generate_inital_audio_rays(Object *parent
  *  \returns
  *    The T60 time in seconds for each band
  */
-CArray<Vec2> calculate_t60_time(vector<Object *> &objVec)
+CoefficentArray calculate_t60_time(vector<Object *> &objVec)
 {
   float absorbtionSurfaceArea = 0.f;
   float roomVolume = 0.f;
@@ -497,7 +631,7 @@ CArray<Vec2> calculate_t60_time(vector<Object *> &objVec)
       + to_string(absorbtionSurfaceArea)));
   static_cast<void>(Logger(Logger::L_MSG, "Room Volume: " 
       + to_string(roomVolume)));
-  CArray<Vec2> returnVec(absorbtionRay.get_amp());
+  CoefficentArray returnVec(absorbtionRay.get_amp());
   for(size_t i = 0; i < returnVec.size(); ++i)
   {
     returnVec[i].y = (0.161f * roomVolume) 
@@ -510,35 +644,240 @@ CArray<Vec2> calculate_t60_time(vector<Object *> &objVec)
  *  Calculates the average peak amplitude of each ray to find the average amount
  *  of gain that the listener recieves
  */
-float calculate_listener_peak_amplitude(vector<vector<AudioRay *>> &raySet)
+float calculate_listener_peak_amplitude(const RayPaths &paths)
 {
   float attenuation = 0.f;
 
-  for(vector<AudioRay *> &rays : raySet)
+  for(size_t i = 0; i < paths.size(); ++i)
   {
-    attenuation += rays.back()->get_amp_average();
+    attenuation += paths.get_energy_average(i);
   }
 
   return attenuation;
 }
 
-vector<vector<AudioRay *>> generate_audio_rays_from_scene(
-    vector<Object *> &objVec, const Vec2 &relativePos
-    , const Vec2 &relativeSize, const Vec2 &scalar)
+/*!
+ *  Keeps a traced path if it ended at the listener
+ */
+void finish_trace_ray(const TraceRay &ray, const EdgeTable &table
+    , RayPaths &output)
+{
+  float average = ray.energy.average(table.get_band_count());
+  if(average < 0.f || average > 1.f)
+  {
+    Logger(Logger::L_ERR, "INVALID VEC AMP");
+  }
+
+  if(ray.collision.collision && average > 0.f
+      && table.get_kind(ray.collision.edge) == EdgeTable::EK_LISTENER)
+  {
+    output.add_path(ray.points.data(), ray.levels.data(), ray.points.size()
+        , ray.energy);
+  }
+}
+
+/*!
+ *  Traces a contiguous range of inital rays, keeping only the paths that end
+ *  at the listener or adding every pass through a volumetric receiver to its
+ *  histogram.
+ *
+ *  NOTE: This is run by the worker threads so it must only read from table
+ *  and grid and write to its own output
+ *
+ *  \param table
+ *    The compiled edges of the scene
+ *  \param grid
+ *    The collision grid of the scene or nullptr for brute force collisions
+ *  \param srcPos
+ *    The position every inital ray starts at
+ *  \param rayEnds
+ *    The far end of each inital ray of the scene
+ *  \param begin
+ *    The first inital ray in the range
+ *  \param end
+ *    One past the last inital ray in the range
+ *  \param termination
+ *    When rays stop bouncing
+ *  \param scalar
+ *    The scalar from physical space into the scene
+ *  \param receiver
+ *    The volumetric receiver of the scene or nullptr if rays must hit the
+ *    listener
+ *  \param output
+ *    The paths that hit the listener, in the order of their inital rays
+ *  \param histogram
+ *    The energy that passed through the volumetric receiver
+ */
+void trace_audio_ray_range(const EdgeTable &table
+    , const CollisionGrid *grid, const Vec2 &srcPos
+    , const vector<Vec2> &rayEnds, const size_t &begin, const size_t &end
+    , const RayTermination &termination, const Vec2 &scalar
+    , const VolumeReceiver *receiver, RayPaths &output
+    , EnergyHistogram &histogram)
+{
+  TraceRay ray;
+  for(size_t r = begin; r < end; ++r)
+  {
+    // First check for the inital collision
+    ray.start(srcPos, rayEnds[r], r);
+    detect_collisions(table, grid, receiver, histogram, ray);
+    // Then loop until either the collision max is hit or the ray is inaudible
+    // meaning we probably can't hit the listener or we hit the listener
+    while(continue_trace_ray(table, ray, termination))
+    {
+      resolve_collision(ray, table, scalar);
+      detect_collisions(table, grid, receiver, histogram, ray);
+    }
+
+    finish_trace_ray(ray, table, output);
+  }
+}
+
+/*!
+ *  Traces a contiguous range of inital rays the same as trace_audio_ray_range
+ *  but in packets of neighbouring rays.
+ *
+ *  Neighbouring rays of the source's cone start coherent, so a packet shares
+ *  its grid traversal and each edge is tested against several rays at once.
+ *  After every bounce the rays are regrouped by the edge they hit, as rays
+ *  reflecting off the same edge stay coherent while the rest leave the
+ *  packet. Groups too small to be worth a packet are traced as single rays.
+ *  The paths are exactly the same as tracing each ray on its own.
+ *
+ *  \param packetSize
+ *    The number of inital rays in each packet, up to RayPacket::MAX_SIZE
+ */
+void trace_audio_ray_packets(const EdgeTable &table
+    , const CollisionGrid *grid, const Vec2 &srcPos
+    , const vector<Vec2> &rayEnds, const size_t &begin, const size_t &end
+    , const RayTermination &termination, const Vec2 &scalar
+    , const size_t &packetSize, const VolumeReceiver *receiver
+    , RayPaths &output, EnergyHistogram &histogram)
+{
+  const EdgeSpan tableSpan{table.beginX.data(), table.beginY.data()
+    , table.endX.data(), table.endY.data(), nullptr, 0u, table.size()};
+
+  vector<TraceRay> rays(packetSize);
+  vector<vector<size_t>> packets;
+  vector<size_t> bounced;
+
+  for(size_t first = begin; first < end; first += packetSize)
+  {
+    const size_t count = min(first + packetSize, end) - first;
+
+    packets.resize(1);
+    packets[0].clear();
+    for(size_t r = 0; r < count; ++r)
+    {
+      rays[r].start(srcPos, rayEnds[first + r], first + r);
+      packets[0].push_back(r);
+    }
+
+    while(!packets.empty())
+    {
+      vector<size_t> members = move(packets.back());
+      packets.pop_back();
+
+      if(members.size() < RayPacket::MIN_SIZE)
+      {
+        for(size_t r : members)
+        {
+          detect_collisions(table, grid, receiver, histogram, rays[r]);
+        }
+      }
+      else
+      {
+        RayPacket packet;
+        for(size_t r : members)
+        {
+          packet.add(rays[r].begin, rays[r].end, rays[r].collision.edge);
+        }
+
+        PacketHits hits;
+        if(grid)
+        {
+          grid->find_closest_edges(packet, hits);
+        }
+        else
+        {
+          intersect_ray_packet(tableSpan, packet
+              , (1u << packet.count) - 1u, hits);
+        }
+
+        for(size_t lane = 0; lane < packet.count; ++lane)
+        {
+          TraceRay &ray = rays[members[lane]];
+          EdgeHit hit = hits.get(lane);
+          if(!hit.is_hit())
+          {
+            ray.collision = CollisionInfo();
+            continue;
+          }
+
+          apply_collision(table, receiver, histogram, ray, hit.edge
+              , ray.begin + ((ray.end - ray.begin) * hit.u));
+        }
+      }
+
+      // The rays that will bounce again, grouped by the edge they hit
+      bounced.clear();
+      for(size_t r : members)
+      {
+        TraceRay &ray = rays[r];
+        if(continue_trace_ray(table, ray, termination))
+        {
+          resolve_collision(ray, table, scalar);
+          bounced.push_back(r);
+        }
+      }
+
+      while(!bounced.empty())
+      {
+        uint32_t edge = rays[bounced.front()].collision.edge;
+        vector<size_t> group, rest;
+        for(size_t r : bounced)
+        {
+          (rays[r].collision.edge == edge ? group : rest).push_back(r);
+        }
+        packets.push_back(move(group));
+        bounced = move(rest);
+      }
+    }
+
+    for(size_t r = 0; r < count; ++r)
+    {
+      finish_trace_ray(rays[r], table, output);
+    }
+  }
+}
+
+RayPaths generate_audio_rays_from_scene(
+    const vector<Object *> &objVec, const EdgeTable &table
+    , const Vec2 &scalar, const RayGenerationInfo &info
+    , const CollisionGrid *grid, EnergyHistogram *histogram)
 {
   // Set defaults and get the source object
-  Object *parent;
+  Object *parent = nullptr;
   Vec2 srcPos = {0.f, 0.f};
-  vector<vector<AudioRay *>> rayVec;
-  vector<vector<AudioRay *>> returnVec;
+  RayPaths returnPaths;
+  returnPaths.clear(table.get_band_count());
+  if(histogram)
+  {
+    histogram->clear(table.get_band_count());
+  }
 
+  VolumeReceiver volumeReceiver;
+  Listener *listener = nullptr;
   for(Object *obj : objVec)
   {
-    if(obj->get_type_name() == "Source")
+    if(!parent && obj->get_type_name() == "Source")
     {
       parent = obj;
       srcPos = get_object_center(obj);
-      break;
+    }
+    else if(!listener && obj->get_type_name() == "Listener")
+    {
+      listener = dynamic_cast<Listener *>(obj);
     }
   }
 
@@ -548,90 +887,154 @@ vector<vector<AudioRay *>> generate_audio_rays_from_scene(
   {
     static_cast<void>(Logger(Logger::L_ERR, string("No valid Source object ")
         + " found in given audio vector during scene audio ray generation!"));
-    return returnVec;
+    return returnPaths;
+  }
+
+  // Rays pass through a volumetric listener so they are recorded by it
+  // instead of ending there
+  const VolumeReceiver *receiver = nullptr;
+  if(listener && listener->get_receiver_mode() == Listener::R_VOLUME)
+  {
+    if(histogram)
+    {
+      Vec2 size = listener->get_size();
+      volumeReceiver.listener = listener;
+      volumeReceiver.center = get_object_center(listener);
+      volumeReceiver.radius = min(size.x, size.y) / 2.f;
+      volumeReceiver.scalar = max(scalar.x, scalar.y);
+      volumeReceiver.rayEnergy = 1.f / max(source->get_rays(), 1);
+      receiver = &volumeReceiver;
+    }
+    else
+    {
+      static_cast<void>(Logger(Logger::L_ERR, string("A volumetric listener ")
+            + "needs a histogram to record the rays passing through it"));
+    }
   }
 
   int maxChecks = source->get_checks();
+  // The threshold is in dB of energy
+  RayTermination termination{maxChecks, (source->get_threshold() < 0.f)
+    ? pow(10.f, source->get_threshold() / 10.f) : 0.f
+      , source->get_roulette()};
 
-  // Add a wall for collision detection
-  Barrier wall(relativePos, relativeSize, "wall");
-  objVec.push_back(&wall);
+  // Only use the grid if it has been built for the scene
+  if(!info.useCollisionGrid || (grid && !grid->is_built()))
+  {
+    grid = nullptr;
+  }
 
   // Generate the inital waves in the TODO: given cone
-  rayVec = generate_inital_audio_rays(parent, srcPos);
+  vector<Vec2> rayEnds = generate_inital_audio_rays(parent);
 
   float listenerAmp = 0.f;
 
-  // Generate subsequent rays based off collisions
-  for(vector<AudioRay *> _rayVec : rayVec)
+  // Split the inital rays into contiguous ranges, one for each worker
+  size_t threadCount = (info.threadCount == 0u) 
+    ? thread::hardware_concurrency() : info.threadCount;
+  if(threadCount == 0)
   {
-    // First check for the inital collision
-    AudioRay *ray = _rayVec.front();
-    float amp = map_range_to(ray->get_amp_average(), 0.f, 1.f, 60.f, 160.f);
-    /*
-    Logger(Logger::L_ERR, "Average AMP: " + to_string(ray->get_amp_average()));
-    */
-    ray->set_color(sf::Color(0.f, amp, 0.f, amp));
-    CollisionInfo collisionInfo = detect_collisions(objVec, ray); 
-    // Then loop until either the collision max is hit meaning we probably 
-    // can't hit the listener or we hit the listener
-    for(int i = 0; i < maxChecks && collisionInfo.collision
-        && (collisionInfo.parent 
-          && !(collisionInfo.parent->get_type_name() == "Listener")); ++i)
-    {
-      AudioRay *newRay = resolve_collision(ray, collisionInfo, scalar);
-      amp = map_range_to(newRay->get_amp_average(), 0.f, 1.f, 60.f, 160.f);
-      newRay->set_color(sf::Color(0.f, amp, 0.f, amp));
-      ray = newRay;
-      _rayVec.push_back(ray);
-      collisionInfo = detect_collisions(objVec, ray);
-    }
+    threadCount = 1;
+  }
+  if(threadCount > rayEnds.size())
+  {
+    threadCount = (rayEnds.size() == 0) ? 1 : rayEnds.size();
+  }
+  size_t rangeSize = (rayEnds.size() + threadCount - 1) / threadCount;
 
-    if(_rayVec.back()->get_amp_average() < 0.f || _rayVec.back()->get_amp_average() > 1.f)
+  // Packets are kept whole within a range
+  size_t packetSize = min<size_t>(info.packetSize, RayPacket::MAX_SIZE);
+  if(packetSize > 1)
+  {
+    rangeSize = (rangeSize + packetSize - 1) / packetSize * packetSize;
+  }
+  auto trace_range = [&](size_t begin, size_t end, RayPaths &output
+      , EnergyHistogram &outputHistogram)
+  {
+    if(packetSize > 1)
     {
-      Logger(Logger::L_ERR, "INVALID VEC AMP");
+      trace_audio_ray_packets(table, grid, srcPos, rayEnds, begin, end
+          , termination, scalar, packetSize, receiver, output
+          , outputHistogram);
     }
-
-    // TODO: Instead of adding to a new vec on successful hit lets remove from
-    // vec
-    if(collisionInfo.parent && _rayVec.back()->get_amp_average() > 0.f
-        && collisionInfo.parent->get_type_name() == "Listener")
+    else
     {
-      returnVec.push_back(_rayVec);
+      trace_audio_ray_range(table, grid, srcPos, rayEnds, begin, end
+          , termination, scalar, receiver, output, outputHistogram);
     }
-    else 
+  };
+
+  // Each worker writes only into its own output so no locking is needed
+  vector<RayPaths> workerOutputs(threadCount);
+  vector<EnergyHistogram> workerHistograms(threadCount);
+  for(size_t i = 0; i < threadCount; ++i)
+  {
+    workerOutputs[i].clear(table.get_band_count());
+    workerHistograms[i].clear(table.get_band_count());
+  }
+  vector<thread> workers;
+  for(size_t i = 1; i < threadCount; ++i)
+  {
+    size_t begin = min(i * rangeSize, rayEnds.size());
+    size_t end = min(begin + rangeSize, rayEnds.size());
+    workers.emplace_back(trace_range, begin, end, ref(workerOutputs[i])
+        , ref(workerHistograms[i]));
+  }
+  // The calling thread traces the first range itself
+  trace_range(0, min(rangeSize, rayEnds.size()), workerOutputs[0]
+      , workerHistograms[0]);
+
+  for(thread &worker : workers)
+  {
+    worker.join();
+  }
+
+  // Merge in range order so the paths match a serial trace
+  size_t pathCount = 0, pointCount = 0;
+  for(const RayPaths &workerOutput : workerOutputs)
+  {
+    pathCount += workerOutput.size();
+    pointCount += workerOutput.get_point_total();
+  }
+  returnPaths.reserve(pathCount, pointCount);
+  for(const RayPaths &workerOutput : workerOutputs)
+  {
+    returnPaths.append(workerOutput);
+  }
+  if(receiver)
+  {
+    for(const EnergyHistogram &workerHistogram : workerHistograms)
     {
-      for(AudioRay * _ray : _rayVec)
-      {
-        delete _ray;
-      }
+      histogram->merge(workerHistogram);
     }
+
+    static_cast<void>(Logger(Logger::L_MSG
+          , "Volumetric listener recorded " + to_string(histogram->size())
+          + " histogram bins"));
   }
 
   // Get smallest vec size and set color to be bolded
   struct SmallestVecSize
   {
-    int index;
-    int size;
-  } smallestVecSize {0, maxChecks};
-  int totalSizes = 0.f;
+    size_t index;
+    size_t size;
+  } smallestVecSize {0, static_cast<size_t>(maxChecks)};
 
   // Get the louded ray
   struct LoudestRay
   {
-    int index;
+    size_t index;
     float amp;
   } loudestRay {0, 0.f};
 
-  for(int i = 0; i < returnVec.size(); ++i)
+  for(size_t i = 0; i < returnPaths.size(); ++i)
   {
-    totalSizes += returnVec[i].size();
-    if(returnVec[i].size() < smallestVecSize.size)
+    if(returnPaths.get_segment_count(i) < smallestVecSize.size)
     {
       smallestVecSize.index = i;
-      smallestVecSize.size = returnVec[i].size();
+      smallestVecSize.size = returnPaths.get_segment_count(i);
     }
-    float amp = returnVec[i].back()->get_amp_average();
+    float amp = returnPaths.get_energy_average(i);
     if(loudestRay.amp < amp)
     {
       loudestRay.amp = amp;
@@ -641,39 +1044,22 @@ vector<vector<AudioRay *>> generate_audio_rays_from_scene(
 
   // Loudest and Smallest Ray
   // NOTE: Accounting for case of no rays found and scene being 'invalid'
-  if(loudestRay.index == smallestVecSize.index && returnVec.size() > 0)
+  if(loudestRay.index == smallestVecSize.index && returnPaths.size() > 0)
   {
-    for(AudioRay *ray : returnVec[loudestRay.index])
-    {
-      float amp = map_range_to(ray->get_amp_average(), 0.f, 1.f, 130.f, 230.f);
-      ray->set_color(sf::Color(amp, 0.f, amp, amp)); 
-    }
+    returnPaths.set_highlight(loudestRay.index
+        , RayPaths::PH_LOUDEST_SHORTEST);
   }
-  else if(returnVec.size() > 0)
+  else if(returnPaths.size() > 0)
   {
-    // Loudest Ray
-    for(AudioRay *ray : returnVec[loudestRay.index])
-    {
-      float amp = map_range_to(ray->get_amp_average(), 0.f, 1.f, 130.f, 230.f);
-      ray->set_color(sf::Color(amp, amp, 0.f, amp)); 
-    }
-  
-    // Smallest Ray
-    for(AudioRay *ray : returnVec[smallestVecSize.index])
-    {
-      float amp = map_range_to(ray->get_amp_average(), 0.f, 1.f, 130.f, 230.f);
-      ray->set_color(sf::Color(0.f, amp, amp, amp)); 
-    }
+    returnPaths.set_highlight(loudestRay.index, RayPaths::PH_LOUDEST);
+    returnPaths.set_highlight(smallestVecSize.index, RayPaths::PH_SHORTEST);
   }
 
   static_cast<void>(Logger(Logger::L_MSG
         , "Number of rays that hit the listener: " 
-        + to_string(returnVec.size())));
-
-  listenerAmp = calculate_listener_peak_amplitude(returnVec);
+        + to_string(returnPaths.size())));
 
-  // Remove the added wall since we don't need to draw it
-  objVec.pop_back();
+  listenerAmp = calculate_listener_peak_amplitude(returnPaths);
 
-  return returnVec;
+  return returnPaths;
 }
@@ -0,0 +1,565 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   intersect.cpp
+ *
+ *  \brief
+ *    Implementation of the vectorized ray and edge intersection kernels
+ *
+ *    Every kernel uses the same line-line intersection as
+ *    line_line_intersection with its operations in the same order so they all
+ *    give bitwise identical results:
+ *
+ *    denominator = (eY * rX) - (eX * rY)
+ *    uA = ((eX * oY) - (eY * oX)) / denominator
+ *    uB = ((rX * oY) - (rY * oX)) / denominator
+ *
+ *    e = edgeEnd - edgeBegin
+ *    r = rayEnd - rayBegin
+ *    o = rayBegin - edgeBegin
+ */
+
+#include "intersect.h"
+
+#include <cmath>
+#include <limits>
+
+#include "simd.h"
+
+using namespace std;
+
+namespace
+{
+  const uint32_t NO_HIT = 0xFFFFFFFFu;
+
+  /*!
+   *  Keeps the closer of two hits, using the edge index to break ties so the
+   *  order hits are found in doesn't matter
+   */
+  inline void keep_closest(const uint32_t &edge, const float &distance
+      , const float &u, EdgeHit &closest)
+  {
+    if(!closest.is_hit() || distance < closest.distance
+        || (distance == closest.distance && edge < closest.edge))
+    {
+      closest.edge = edge;
+      closest.distance = distance;
+      closest.u = u;
+    }
+  }
+
+  inline void intersect_edge(const EdgeSpan &span, const size_t &i
+      , const float &rayBeginX, const float &rayBeginY, const float &rX
+      , const float &rY, const uint32_t &ignoreEdge, EdgeHit &closest)
+  {
+    uint32_t edge = span.edgeIds ? span.edgeIds[i]
+      : span.firstEdge + static_cast<uint32_t>(i);
+    if(edge == ignoreEdge)
+    {
+      return;
+    }
+
+    float eX = span.endX[i] - span.beginX[i];
+    float eY = span.endY[i] - span.beginY[i];
+    float denominator = eY * rX - eX * rY;
+
+    // Ignore parallel lines
+    if(denominator == 0)
+    {
+      return;
+    }
+
+    float oX = rayBeginX - span.beginX[i];
+    float oY = rayBeginY - span.beginY[i];
+    float uA = (eX * oY - eY * oX) / denominator;
+    float uB = (rX * oY - rY * oX) / denominator;
+
+    if(!(uA >= 0 && uA <= 1 && uB >= 0 && uB <= 1))
+    {
+      return;
+    }
+
+    float dX = (rayBeginX + rX * uA) - rayBeginX;
+    float dY = (rayBeginY + rY * uA) - rayBeginY;
+    float distance = sqrt(dX * dX + dY * dY);
+
+    // Ignore the point the ray starts at
+    if(distance <= 0.f)
+    {
+      return;
+    }
+
+    keep_closest(edge, distance, uA, closest);
+  }
+
+  void intersect_edges_scalar(const EdgeSpan &span, const size_t &first
+      , const Vec2 &rayBegin, const Vec2 &rayEnd, const uint32_t &ignoreEdge
+      , EdgeHit &closest)
+  {
+    const float rX = rayEnd.x - rayBegin.x;
+    const float rY = rayEnd.y - rayBegin.y;
+
+    for(size_t i = first; i < span.count; ++i)
+    {
+      intersect_edge(span, i, rayBegin.x, rayBegin.y, rX, rY, ignoreEdge
+          , closest);
+    }
+  }
+
+  void intersect_ray_packet_scalar(const EdgeSpan &span
+      , const RayPacket &packet, const uint32_t &laneMask, PacketHits &hits)
+  {
+    for(size_t lane = 0; lane < packet.count; ++lane)
+    {
+      if(!(laneMask & (1u << lane)))
+      {
+        continue;
+      }
+
+      EdgeHit closest = hits.get(lane);
+      for(size_t i = 0; i < span.count; ++i)
+      {
+        intersect_edge(span, i, packet.beginX[lane], packet.beginY[lane]
+            , packet.directionX[lane], packet.directionY[lane]
+            , packet.ignoreEdge[lane], closest);
+      }
+      hits.edge[lane] = closest.edge;
+      hits.distance[lane] = closest.distance;
+      hits.u[lane] = closest.u;
+    }
+  }
+
+#if ARMS_SSE2
+  void intersect_edges_sse(const EdgeSpan &span, const Vec2 &rayBegin
+      , const Vec2 &rayEnd, const uint32_t &ignoreEdge, EdgeHit &closest)
+  {
+    const __m128 rayBeginX = _mm_set1_ps(rayBegin.x);
+    const __m128 rayBeginY = _mm_set1_ps(rayBegin.y);
+    const __m128 rX = _mm_set1_ps(rayEnd.x - rayBegin.x);
+    const __m128 rY = _mm_set1_ps(rayEnd.y - rayBegin.y);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    // SSE2 only has signed integer compares so indicies are offset by the
+    // sign bit to compare them as unsigned
+    const __m128i signBit = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    const __m128i ignore = _mm_set1_epi32(static_cast<int>(ignoreEdge));
+    const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+    __m128 bestDistance = _mm_set1_ps(numeric_limits<float>::infinity());
+    __m128 bestU = zero;
+    __m128i bestEdge = _mm_set1_epi32(static_cast<int>(NO_HIT));
+
+    size_t i = 0;
+    for(; i + 4 <= span.count; i += 4)
+    {
+      __m128i edge = span.edgeIds
+        ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(span.edgeIds + i))
+        : _mm_add_epi32(_mm_set1_epi32(static_cast<int>(span.firstEdge + i))
+            , laneOffsets);
+
+      __m128 beginX = _mm_loadu_ps(span.beginX + i);
+      __m128 beginY = _mm_loadu_ps(span.beginY + i);
+      __m128 eX = _mm_sub_ps(_mm_loadu_ps(span.endX + i), beginX);
+      __m128 eY = _mm_sub_ps(_mm_loadu_ps(span.endY + i), beginY);
+      __m128 denominator = _mm_sub_ps(_mm_mul_ps(eY, rX), _mm_mul_ps(eX, rY));
+
+      __m128 oX = _mm_sub_ps(rayBeginX, beginX);
+      __m128 oY = _mm_sub_ps(rayBeginY, beginY);
+      __m128 uA = _mm_div_ps(
+          _mm_sub_ps(_mm_mul_ps(eX, oY), _mm_mul_ps(eY, oX)), denominator);
+      __m128 uB = _mm_div_ps(
+          _mm_sub_ps(_mm_mul_ps(rX, oY), _mm_mul_ps(rY, oX)), denominator);
+
+      __m128 dX = _mm_sub_ps(_mm_add_ps(rayBeginX, _mm_mul_ps(rX, uA))
+          , rayBeginX);
+      __m128 dY = _mm_sub_ps(_mm_add_ps(rayBeginY, _mm_mul_ps(rY, uA))
+          , rayBeginY);
+      __m128 distance = _mm_sqrt_ps(
+          _mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dY, dY)));
+
+      __m128 valid = _mm_and_ps(_mm_cmpneq_ps(denominator, zero)
+          , _mm_and_ps(
+            _mm_and_ps(_mm_cmpge_ps(uA, zero), _mm_cmple_ps(uA, one))
+            , _mm_and_ps(_mm_cmpge_ps(uB, zero), _mm_cmple_ps(uB, one))));
+      valid = _mm_and_ps(valid, _mm_cmpgt_ps(distance, zero));
+      valid = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(edge, ignore))
+          , valid);
+
+      __m128 lowerEdge = _mm_castsi128_ps(_mm_cmplt_epi32(
+            _mm_xor_si128(edge, signBit), _mm_xor_si128(bestEdge, signBit)));
+      __m128 closer = _mm_or_ps(_mm_cmplt_ps(distance, bestDistance)
+          , _mm_and_ps(_mm_cmpeq_ps(distance, bestDistance), lowerEdge));
+      __m128 update = _mm_and_ps(valid, closer);
+
+      // Branchless select of the closer hit in each lane
+      bestDistance = _mm_or_ps(_mm_and_ps(update, distance)
+          , _mm_andnot_ps(update, bestDistance));
+      bestU = _mm_or_ps(_mm_and_ps(update, uA), _mm_andnot_ps(update, bestU));
+      __m128i updateInt = _mm_castps_si128(update);
+      bestEdge = _mm_or_si128(_mm_and_si128(updateInt, edge)
+          , _mm_andnot_si128(updateInt, bestEdge));
+    }
+
+    alignas(16) float laneDistance[4];
+    alignas(16) float laneU[4];
+    alignas(16) uint32_t laneEdge[4];
+    _mm_store_ps(laneDistance, bestDistance);
+    _mm_store_ps(laneU, bestU);
+    _mm_store_si128(reinterpret_cast<__m128i *>(laneEdge), bestEdge);
+    for(int lane = 0; lane < 4; ++lane)
+    {
+      if(laneEdge[lane] != NO_HIT)
+      {
+        keep_closest(laneEdge[lane], laneDistance[lane], laneU[lane], closest);
+      }
+    }
+
+    intersect_edges_scalar(span, i, rayBegin, rayEnd, ignoreEdge, closest);
+  }
+#endif
+
+#if ARMS_X86
+  ARMS_TARGET_AVX2
+  void intersect_edges_avx2(const EdgeSpan &span, const Vec2 &rayBegin
+      , const Vec2 &rayEnd, const uint32_t &ignoreEdge, EdgeHit &closest)
+  {
+    const __m256 rayBeginX = _mm256_set1_ps(rayBegin.x);
+    const __m256 rayBeginY = _mm256_set1_ps(rayBegin.y);
+    const __m256 rX = _mm256_set1_ps(rayEnd.x - rayBegin.x);
+    const __m256 rY = _mm256_set1_ps(rayEnd.y - rayBegin.y);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256i signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i ignore = _mm256_set1_epi32(static_cast<int>(ignoreEdge));
+    const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    __m256 bestDistance = _mm256_set1_ps(numeric_limits<float>::infinity());
+    __m256 bestU = zero;
+    __m256i bestEdge = _mm256_set1_epi32(static_cast<int>(NO_HIT));
+
+    size_t i = 0;
+    for(; i + 8 <= span.count; i += 8)
+    {
+      __m256i edge = span.edgeIds
+        ? _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(span.edgeIds + i))
+        : _mm256_add_epi32(
+            _mm256_set1_epi32(static_cast<int>(span.firstEdge + i))
+            , laneOffsets);
+
+      __m256 beginX = _mm256_loadu_ps(span.beginX + i);
+      __m256 beginY = _mm256_loadu_ps(span.beginY + i);
+      __m256 eX = _mm256_sub_ps(_mm256_loadu_ps(span.endX + i), beginX);
+      __m256 eY = _mm256_sub_ps(_mm256_loadu_ps(span.endY + i), beginY);
+      __m256 denominator = _mm256_sub_ps(_mm256_mul_ps(eY, rX)
+          , _mm256_mul_ps(eX, rY));
+
+      __m256 oX = _mm256_sub_ps(rayBeginX, beginX);
+      __m256 oY = _mm256_sub_ps(rayBeginY, beginY);
+      __m256 uA = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(eX, oY)
+            , _mm256_mul_ps(eY, oX)), denominator);
+      __m256 uB = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(rX, oY)
+            , _mm256_mul_ps(rY, oX)), denominator);
+
+      __m256 dX = _mm256_sub_ps(
+          _mm256_add_ps(rayBeginX, _mm256_mul_ps(rX, uA)), rayBeginX);
+      __m256 dY = _mm256_sub_ps(
+          _mm256_add_ps(rayBeginY, _mm256_mul_ps(rY, uA)), rayBeginY);
+      __m256 distance = _mm256_sqrt_ps(
+          _mm256_add_ps(_mm256_mul_ps(dX, dX), _mm256_mul_ps(dY, dY)));
+
+      __m256 valid = _mm256_and_ps(
+          _mm256_cmp_ps(denominator, zero, _CMP_NEQ_UQ)
+          , _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(uA, zero, _CMP_GE_OQ)
+              , _mm256_cmp_ps(uA, one, _CMP_LE_OQ))
+            , _mm256_and_ps(_mm256_cmp_ps(uB, zero, _CMP_GE_OQ)
+              , _mm256_cmp_ps(uB, one, _CMP_LE_OQ))));
+      valid = _mm256_and_ps(valid, _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+      valid = _mm256_andnot_ps(
+          _mm256_castsi256_ps(_mm256_cmpeq_epi32(edge, ignore)), valid);
+
+      __m256 lowerEdge = _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+            _mm256_xor_si256(bestEdge, signBit)
+            , _mm256_xor_si256(edge, signBit)));
+      __m256 closer = _mm256_or_ps(
+          _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ)
+          , _mm256_and_ps(_mm256_cmp_ps(distance, bestDistance, _CMP_EQ_OQ)
+            , lowerEdge));
+      __m256 update = _mm256_and_ps(valid, closer);
+
+      // Branchless select of the closer hit in each lane
+      bestDistance = _mm256_blendv_ps(bestDistance, distance, update);
+      bestU = _mm256_blendv_ps(bestU, uA, update);
+      bestEdge = _mm256_castps_si256(_mm256_blendv_ps(
+            _mm256_castsi256_ps(bestEdge), _mm256_castsi256_ps(edge), update));
+    }
+
+    alignas(32) float laneDistance[8];
+    alignas(32) float laneU[8];
+    alignas(32) uint32_t laneEdge[8];
+    _mm256_store_ps(laneDistance, bestDistance);
+    _mm256_store_ps(laneU, bestU);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(laneEdge), bestEdge);
+    for(int lane = 0; lane < 8; ++lane)
+    {
+      if(laneEdge[lane] != NO_HIT)
+      {
+        keep_closest(laneEdge[lane], laneDistance[lane], laneU[lane], closest);
+      }
+    }
+
+    intersect_edges_scalar(span, i, rayBegin, rayEnd, ignoreEdge, closest);
+  }
+#endif
+
+#if ARMS_SSE2
+  void intersect_ray_packet_sse(const EdgeSpan &span, const RayPacket &packet
+      , const uint32_t &laneMask, PacketHits &hits)
+  {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128i signBit = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    const __m128i noHit = _mm_set1_epi32(static_cast<int>(NO_HIT));
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+
+    for(size_t lane = 0; lane < packet.count; lane += 4)
+    {
+      uint32_t mask = (laneMask >> lane) & 0xFu;
+      if(!mask)
+      {
+        continue;
+      }
+
+      const __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(
+            _mm_and_si128(_mm_set1_epi32(static_cast<int>(mask)), laneBits)
+            , laneBits));
+      const __m128 rayBeginX = _mm_load_ps(packet.beginX + lane);
+      const __m128 rayBeginY = _mm_load_ps(packet.beginY + lane);
+      const __m128 rX = _mm_load_ps(packet.directionX + lane);
+      const __m128 rY = _mm_load_ps(packet.directionY + lane);
+      const __m128i ignore = _mm_load_si128(
+          reinterpret_cast<const __m128i *>(packet.ignoreEdge + lane));
+
+      __m128 bestDistance = _mm_load_ps(hits.distance + lane);
+      __m128 bestU = _mm_load_ps(hits.u + lane);
+      __m128i bestEdge = _mm_load_si128(
+          reinterpret_cast<const __m128i *>(hits.edge + lane));
+
+      for(size_t i = 0; i < span.count; ++i)
+      {
+        uint32_t edgeId = span.edgeIds ? span.edgeIds[i]
+          : span.firstEdge + static_cast<uint32_t>(i);
+        __m128i edge = _mm_set1_epi32(static_cast<int>(edgeId));
+
+        // The edge is the same for every lane so it is only loaded once
+        __m128 beginX = _mm_set1_ps(span.beginX[i]);
+        __m128 beginY = _mm_set1_ps(span.beginY[i]);
+        __m128 eX = _mm_set1_ps(span.endX[i] - span.beginX[i]);
+        __m128 eY = _mm_set1_ps(span.endY[i] - span.beginY[i]);
+        __m128 denominator = _mm_sub_ps(_mm_mul_ps(eY, rX)
+            , _mm_mul_ps(eX, rY));
+
+        __m128 oX = _mm_sub_ps(rayBeginX, beginX);
+        __m128 oY = _mm_sub_ps(rayBeginY, beginY);
+        __m128 uA = _mm_div_ps(
+            _mm_sub_ps(_mm_mul_ps(eX, oY), _mm_mul_ps(eY, oX)), denominator);
+        __m128 uB = _mm_div_ps(
+            _mm_sub_ps(_mm_mul_ps(rX, oY), _mm_mul_ps(rY, oX)), denominator);
+
+        __m128 dX = _mm_sub_ps(_mm_add_ps(rayBeginX, _mm_mul_ps(rX, uA))
+            , rayBeginX);
+        __m128 dY = _mm_sub_ps(_mm_add_ps(rayBeginY, _mm_mul_ps(rY, uA))
+            , rayBeginY);
+        __m128 distance = _mm_sqrt_ps(
+            _mm_add_ps(_mm_mul_ps(dX, dX), _mm_mul_ps(dY, dY)));
+
+        __m128 valid = _mm_and_ps(_mm_cmpneq_ps(denominator, zero)
+            , _mm_and_ps(
+              _mm_and_ps(_mm_cmpge_ps(uA, zero), _mm_cmple_ps(uA, one))
+              , _mm_and_ps(_mm_cmpge_ps(uB, zero), _mm_cmple_ps(uB, one))));
+        valid = _mm_and_ps(valid, _mm_cmpgt_ps(distance, zero));
+        valid = _mm_and_ps(valid, active);
+        valid = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(edge, ignore))
+            , valid);
+
+        __m128 lowerEdge = _mm_castsi128_ps(_mm_cmplt_epi32(
+              _mm_xor_si128(edge, signBit), _mm_xor_si128(bestEdge, signBit)));
+        __m128 closer = _mm_or_ps(
+            _mm_castsi128_ps(_mm_cmpeq_epi32(bestEdge, noHit))
+            , _mm_or_ps(_mm_cmplt_ps(distance, bestDistance)
+              , _mm_and_ps(_mm_cmpeq_ps(distance, bestDistance), lowerEdge)));
+        __m128 update = _mm_and_ps(valid, closer);
+
+        bestDistance = _mm_or_ps(_mm_and_ps(update, distance)
+            , _mm_andnot_ps(update, bestDistance));
+        bestU = _mm_or_ps(_mm_and_ps(update, uA)
+            , _mm_andnot_ps(update, bestU));
+        __m128i updateInt = _mm_castps_si128(update);
+        bestEdge = _mm_or_si128(_mm_and_si128(updateInt, edge)
+            , _mm_andnot_si128(updateInt, bestEdge));
+      }
+
+      _mm_store_ps(hits.distance + lane, bestDistance);
+      _mm_store_ps(hits.u + lane, bestU);
+      _mm_store_si128(reinterpret_cast<__m128i *>(hits.edge + lane), bestEdge);
+    }
+  }
+#endif
+
+#if ARMS_X86
+  ARMS_TARGET_AVX2
+  void intersect_ray_packet_avx2(const EdgeSpan &span
+      , const RayPacket &packet, const uint32_t &laneMask, PacketHits &hits)
+  {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.f);
+    const __m256i signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i noHit = _mm256_set1_epi32(static_cast<int>(NO_HIT));
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    for(size_t lane = 0; lane < packet.count; lane += 8)
+    {
+      uint32_t mask = (laneMask >> lane) & 0xFFu;
+      if(!mask)
+      {
+        continue;
+      }
+
+      const __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+            _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask))
+              , laneBits), laneBits));
+      const __m256 rayBeginX = _mm256_load_ps(packet.beginX + lane);
+      const __m256 rayBeginY = _mm256_load_ps(packet.beginY + lane);
+      const __m256 rX = _mm256_load_ps(packet.directionX + lane);
+      const __m256 rY = _mm256_load_ps(packet.directionY + lane);
+      const __m256i ignore = _mm256_load_si256(
+          reinterpret_cast<const __m256i *>(packet.ignoreEdge + lane));
+
+      __m256 bestDistance = _mm256_load_ps(hits.distance + lane);
+      __m256 bestU = _mm256_load_ps(hits.u + lane);
+      __m256i bestEdge = _mm256_load_si256(
+          reinterpret_cast<const __m256i *>(hits.edge + lane));
+
+      for(size_t i = 0; i < span.count; ++i)
+      {
+        uint32_t edgeId = span.edgeIds ? span.edgeIds[i]
+          : span.firstEdge + static_cast<uint32_t>(i);
+        __m256i edge = _mm256_set1_epi32(static_cast<int>(edgeId));
+
+        // The edge is the same for every lane so it is only loaded once
+        __m256 beginX = _mm256_set1_ps(span.beginX[i]);
+        __m256 beginY = _mm256_set1_ps(span.beginY[i]);
+        __m256 eX = _mm256_set1_ps(span.endX[i] - span.beginX[i]);
+        __m256 eY = _mm256_set1_ps(span.endY[i] - span.beginY[i]);
+        __m256 denominator = _mm256_sub_ps(_mm256_mul_ps(eY, rX)
+            , _mm256_mul_ps(eX, rY));
+
+        __m256 oX = _mm256_sub_ps(rayBeginX, beginX);
+        __m256 oY = _mm256_sub_ps(rayBeginY, beginY);
+        __m256 uA = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(eX, oY)
+              , _mm256_mul_ps(eY, oX)), denominator);
+        __m256 uB = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(rX, oY)
+              , _mm256_mul_ps(rY, oX)), denominator);
+
+        __m256 dX = _mm256_sub_ps(
+            _mm256_add_ps(rayBeginX, _mm256_mul_ps(rX, uA)), rayBeginX);
+        __m256 dY = _mm256_sub_ps(
+            _mm256_add_ps(rayBeginY, _mm256_mul_ps(rY, uA)), rayBeginY);
+        __m256 distance = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_mul_ps(dX, dX), _mm256_mul_ps(dY, dY)));
+
+        __m256 valid = _mm256_and_ps(
+            _mm256_cmp_ps(denominator, zero, _CMP_NEQ_UQ)
+            , _mm256_and_ps(
+              _mm256_and_ps(_mm256_cmp_ps(uA, zero, _CMP_GE_OQ)
+                , _mm256_cmp_ps(uA, one, _CMP_LE_OQ))
+              , _mm256_and_ps(_mm256_cmp_ps(uB, zero, _CMP_GE_OQ)
+                , _mm256_cmp_ps(uB, one, _CMP_LE_OQ))));
+        valid = _mm256_and_ps(valid
+            , _mm256_cmp_ps(distance, zero, _CMP_GT_OQ));
+        valid = _mm256_and_ps(valid, active);
+        valid = _mm256_andnot_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(edge, ignore)), valid);
+
+        __m256 lowerEdge = _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+              _mm256_xor_si256(bestEdge, signBit)
+              , _mm256_xor_si256(edge, signBit)));
+        __m256 closer = _mm256_or_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(bestEdge, noHit))
+            , _mm256_or_ps(_mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ)
+              , _mm256_and_ps(
+                _mm256_cmp_ps(distance, bestDistance, _CMP_EQ_OQ)
+                , lowerEdge)));
+        __m256 update = _mm256_and_ps(valid, closer);
+
+        bestDistance = _mm256_blendv_ps(bestDistance, distance, update);
+        bestU = _mm256_blendv_ps(bestU, uA, update);
+        bestEdge = _mm256_castps_si256(_mm256_blendv_ps(
+              _mm256_castsi256_ps(bestEdge), _mm256_castsi256_ps(edge)
+              , update));
+      }
+
+      _mm256_store_ps(hits.distance + lane, bestDistance);
+      _mm256_store_ps(hits.u + lane, bestU);
+      _mm256_store_si256(reinterpret_cast<__m256i *>(hits.edge + lane)
+          , bestEdge);
+    }
+  }
+#endif
+}
+
+void intersect_edges(const EdgeSpan &span, const Vec2 &rayBegin
+    , const Vec2 &rayEnd, const uint32_t &ignoreEdge, EdgeHit &closest)
+{
+  // Spans shorter than a vector (i.e. most grid cells) would only run the
+  // scalar tail of the vector kernels
+  switch(span.count < 4 ? SL_SCALAR : get_simd_level())
+  {
+#if ARMS_X86
+    case SL_AVX2:
+      if(span.count >= 8)
+      {
+        intersect_edges_avx2(span, rayBegin, rayEnd, ignoreEdge, closest);
+        return;
+      }
+  #if ARMS_SSE2
+      intersect_edges_sse(span, rayBegin, rayEnd, ignoreEdge, closest);
+      return;
+  #else
+      break;
+  #endif
+#endif
+#if ARMS_SSE2
+    case SL_SSE:
+      intersect_edges_sse(span, rayBegin, rayEnd, ignoreEdge, closest);
+      return;
+#endif
+    default:
+      break;
+  }
+
+  intersect_edges_scalar(span, 0, rayBegin, rayEnd, ignoreEdge, closest);
+}
+
+void intersect_ray_packet(const EdgeSpan &span, const RayPacket &packet
+    , const uint32_t &laneMask, PacketHits &hits)
+{
+  switch(get_simd_level())
+  {
+#if ARMS_X86
+    case SL_AVX2:
+      intersect_ray_packet_avx2(span, packet, laneMask, hits);
+      return;
+#endif
+#if ARMS_SSE2
+    case SL_SSE:
+      intersect_ray_packet_sse(span, packet, laneMask, hits);
+      return;
+#endif
+    default:
+      break;
+  }
+
+  intersect_ray_packet_scalar(span, packet, laneMask, hits);
+}
@@ -24,14 +24,14 @@ using namespace std;
 
 // Doing inverse of direction as y-axis is flipped
 Listener::Listener(const Vec2 &pos, const Vec2  &size, const float &direction
-    , const std::string &pattern)
+    , const std::string &pattern, const std::string &receiver)
   : Object(pos, size, "Listener")
     , directionVec(cos(-direction), sin(-direction))
 {
   directionVec.normalize();
 
   set_color(listenerColor);
-  absortionCoefficents = CArray<Vec2>{{500.f, 0.f}};
+  absortionCoefficents = CoefficentArray{{500.f, 0.f}};
 
   if(pattern == "omni")
   {
@@ -62,6 +62,11 @@ Listener::Listener(const Vec2 &pos, const Vec2  &size, const float &direction
     polarPattern = P_OMNI;
   }
 
+  if(receiver == "volume")
+  {
+    receiverMode = R_VOLUME;
+  }
+
   static_cast<void>(Logger(Logger::L_MSG, "Listener Pattern: " + pattern));
   static_cast<void>(Logger(Logger::L_MSG, "Listener S value: " 
       + to_string(PolarCoefficents[polarPattern])));
@@ -75,3 +80,8 @@ float Listener::get_directional_gain(Vec2 ray)
   ray.normalize();
   return abs((1 - s) + s * directionVec.dot(ray));
 }
+
+Listener::RECEIVER_MODE Listener::get_receiver_mode() const
+{
+  return receiverMode;
+}
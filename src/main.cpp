@@ -10,6 +10,7 @@
 #include "colors.h"
 #include "generator.h"
 #include "object.h"
+#include "preview.h"
 #include "scene.h"
 #include "textbox.h"
 #include "button.h"
@@ -38,7 +39,7 @@ int main()
   Vec2 scenePos = {25.f, 25.f};
   Vec2 sceneSize = DEFAULT_ROOM_SIZE;
   Vec2 buttonContainerPos = {1100.f, 100.f};
-  Vec2 buttonContainerSize = {250.f, 270.f};
+  Vec2 buttonContainerSize = {250.f, 340.f};
   Vec2 buttonContainerPadding = {25.f, 25.f};
   Vec2 buttonContainerItemStart = buttonContainerPos + buttonContainerPadding;
   Vec2 buttonSize = {200.f, 26.f};
@@ -66,7 +67,39 @@ int main()
   //
   //test_wave_with_simple_filter("pluck");
 
-  WaveFile wave;
+  // TEST: WAVE FORMATS ROUND TRIP AND CLAMP
+  //
+  //test_wave_round_trip();
+
+  // TEST: TRACE WITH 1 AND MANY WORKERS
+  //
+  //test_trace_thread_count("testscene1");
+
+  // TEST: SIMD INTERSECTION KERNELS AGAINST SCALAR
+  //
+  //test_intersect_simd_parity();
+
+  // TEST: RENDER EACH PATH AGAINST THE CONVOLUTION
+  //
+  //test_render_mode_parity("testscene1", "pluck");
+
+  // TEST: SPARSE AND DENSE TAPS AGAINST A DIRECT SUM
+  //
+  //test_tap_mixing();
+
+  // TEST: REVERB DECAYS OVER ITS T60
+  //
+  //test_reverb_decay();
+
+  // TEST: LATE BACKGROUND CONVOLUTION
+  //
+  //test_threaded_convolver_late();
+
+  // Only the header of the selected wave is read, renders stream from the
+  // file and only the buttons that need every sample load it
+  WaveReader wave;
+  string wavePath;
+  PreviewStream preview;
 
   /*
    *  Setup scene UI buttons and text
@@ -130,7 +163,7 @@ int main()
         , buttonContainerItemStart.y 
           + 2 * buttonContainerYItemOffset + buttonContainerYSectionOffset}
         , buttonSize
-        , [&wave, &waveTitle] 
+        , [&wave, &wavePath, &waveTitle] 
         {
           nfdchar_t *outPath = NULL;
           nfdresult_t result = NFD_OpenDialog("wav", INPUT_DIR, &outPath);
@@ -153,8 +186,11 @@ int main()
               filePath = filePath.substr(0, dotPos);
             }
 
-            waveTitle->set_title("Wav: " + filePath);
-            wave.open_file(outPath, true);
+            if(wave.open(outPath, true))
+            {
+              waveTitle->set_title("Wav: " + filePath);
+              wavePath = outPath;
+            }
           }
           else if(result != NFD_CANCEL)
           {
@@ -172,7 +208,7 @@ int main()
         , buttonContainerItemStart.y 
           + 2 * buttonContainerYItemOffset + 2 * buttonContainerYSectionOffset}
         , buttonSize
-        , [&scene, &wave] 
+        , [&scene, &wave, &wavePath] 
         {
           if(!scene.is_open())
           {
@@ -192,11 +228,16 @@ int main()
 
           if(result == NFD_OKAY)
           {
-            WaveFile output(wave);
             static_cast<void>(Logger(Logger::L_MSG
                   , "User selected new Wave file"));
-            scene.apply_filter_to_wave(output);
-            output.output_to_file(outPath);
+            WaveReader input;
+            WaveWriter output;
+            if(input.open(wavePath, true)
+                && output.open(outPath, input.get_header()))
+            {
+              scene.render_wave_file(input, output);
+              output.close();
+            }
           }
           else if(result != NFD_CANCEL)
           {
@@ -210,7 +251,7 @@ int main()
         , buttonContainerItemStart.y 
           + 3 * buttonContainerYItemOffset + 2 * buttonContainerYSectionOffset}
         , buttonSize
-        , [&scene, &wave] 
+        , [&scene, &wave, &wavePath] 
         {
           if(!scene.is_open())
           {
@@ -230,7 +271,9 @@ int main()
 
           if(result == NFD_OKAY)
           {
-            WaveFile output(wave);
+            // The T60 is applied to the whole wave so it is loaded here
+            WaveFile output;
+            output.open_file(wavePath, true);
             static_cast<void>(Logger(Logger::L_MSG
                   , "User selected new Wave file"));
             scene.apply_t60_to_wave(output);
@@ -243,6 +286,72 @@ int main()
 
           if(outPath) free(outPath);
         }));
+  /*
+   *  Button for playing the wave through the scene without saving it
+   */
+  bool previewing = false;
+  Button *previewButton = new Button("Preview Ray Output"
+      , {buttonContainerItemStart.x
+        , buttonContainerItemStart.y 
+          + 4 * buttonContainerYItemOffset + 2 * buttonContainerYSectionOffset}
+        , buttonSize
+        , [&scene, &wave, &wavePath, &preview, &previewing
+          , &previewButton]
+        {
+          if(previewing)
+          {
+            previewing = false;
+            preview.stop_preview();
+            previewButton->set_title("Preview Ray Output");
+            return;
+          }
+          if(!scene.is_open())
+          {
+            static_cast<void>(Logger(Logger::L_WRN
+                  , "No valid Scene selected"));
+            return;
+          }
+          if(!wave.is_open())
+          {
+            static_cast<void>(Logger(Logger::L_WRN
+                  , "No valid Wav file selected"));
+            return;
+          }
+
+          // The preview plays from the samples of the whole wave
+          WaveFile input;
+          input.open_file(wavePath, true);
+          unsigned samplingRate = input.get_sampling_rate();
+          preview.load(input.get_samples(), samplingRate
+              , scene.get_impulse_response(samplingRate));
+          preview.play();
+          previewing = true;
+          previewButton->set_title("Stop Preview");
+        });
+  ui.push_back(previewButton);
+  /*
+   *  Button for switching between convolving the scene and rendering each
+   *  path, which is kept as a reference for the convolution
+   */
+  Button *renderModeButton = new Button("Render: Convolution"
+      , {buttonContainerItemStart.x
+        , buttonContainerItemStart.y 
+          + 5 * buttonContainerYItemOffset + 2 * buttonContainerYSectionOffset}
+        , buttonSize
+        , [&scene, &renderModeButton]
+        {
+          if(scene.get_render_mode() == Scene::RM_CONVOLUTION)
+          {
+            scene.set_render_mode(Scene::RM_PER_PATH);
+            renderModeButton->set_title("Render: Per Path");
+          }
+          else
+          {
+            scene.set_render_mode(Scene::RM_CONVOLUTION);
+            renderModeButton->set_title("Render: Convolution");
+          }
+        });
+  ui.push_back(renderModeButton);
   
   /*!
    *  Basic drawing of ui objects and scene objects
@@ -257,6 +366,14 @@ int main()
       }
     }
 
+    // The preview stops on its own once the wave and its tail have played
+    if(previewing && !preview.is_playing())
+    {
+      previewing = false;
+      preview.stop_preview();
+      previewButton->set_title("Preview Ray Output");
+    }
+
     window.clear(backgroundColor);
 
     for(Object *obj : ui)
@@ -32,7 +32,7 @@ std::string Object::get_type_name() const
   return typeName;
 }
 
-const CArray<Vec2> &Object::get_absortion_coefficent() const
+const CoefficentArray &Object::get_absortion_coefficent() const
 {
   return absortionCoefficents; 
 }
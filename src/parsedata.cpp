@@ -21,6 +21,7 @@ using namespace std;
 int get_int_from_line(const string &line, const size_t &startingPos)
 {
   int digit = 0;
+  bool negative = false;
   for(size_t i = startingPos; i < line.size(); ++i)
   {
     char lineChar = line[i];
@@ -29,9 +30,14 @@ int get_int_from_line(const string &line, const size_t &startingPos)
       digit *= 10;
       digit += static_cast<int>(lineChar) - 48;
     }
+    // A minus sign before the first digit
+    else if(lineChar == '-' && digit == 0)
+    {
+      negative = true;
+    }
   }
 
-  return digit;
+  return negative ? -digit : digit;
 }
 
 float get_double_from_line(const string &line, const size_t &startingPos)
@@ -153,6 +159,18 @@ DataMap *read_scene_file(string fileName, const bool &ignoreInputDir)
     {
       dataMap = dataMap->add_child(new DataMap("Rays", dataMap));
     }
+    else if(line.find("Receiver") != string::npos)
+    {
+      dataMap = dataMap->add_child(new DataMap("Receiver", dataMap));
+    }
+    else if(line.find("Threshold") != string::npos)
+    {
+      dataMap = dataMap->add_child(new DataMap("Threshold", dataMap));
+    }
+    else if(line.find("Roulette") != string::npos)
+    {
+      dataMap = dataMap->add_child(new DataMap("Roulette", dataMap));
+    }
     else if(line.find("Pattern") != string::npos)
     {
       dataMap = dataMap->add_child(new DataMap("Pattern", dataMap));
@@ -170,19 +188,19 @@ DataMap *read_scene_file(string fileName, const bool &ignoreInputDir)
             + to_string(size)));
       // Detects if a char was included to denote type of array objects, default
       // is "I" or int
-      if(line.find("Double"))
+      if(line.find("Double") != string::npos)
       {
         dataMap->set_data(new CQueue<float>(size));
       }
-      else if(line.find("String"))
+      else if(line.find("String") != string::npos)
       {
         dataMap->set_data(new CQueue<string>(size));
       }
-      else if(line.find("Vec2"))
+      else if(line.find("Vec2") != string::npos)
       {
         dataMap->set_data(new CQueue<Vec2>(size));
       }
-      else if(line.find("Vec3"))
+      else if(line.find("Vec3") != string::npos)
       {
         dataMap->set_data(new CQueue<Vec3>(size));
       }
@@ -0,0 +1,164 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   preview.cpp
+ *
+ *  \brief
+ *    Implementation of the live preview of a scene
+ */
+
+#include "preview.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+PreviewStream::PreviewStream()
+  : ring(RING_SIZE), chunk(CHUNK_SIZE, 0)
+{
+
+}
+
+PreviewStream::~PreviewStream()
+{
+  // The audio thread has to stop before anything it reads is destroyed
+  stop();
+  stop_producer();
+}
+
+void PreviewStream::load(const AudioBuffer &_samples
+    , const unsigned &samplingRate, const AudioBuffer &_response)
+{
+  stop();
+  stop_producer();
+
+  samples = _samples;
+  response = _response;
+  currentSamplingRate = samplingRate;
+
+  initialize(1, currentSamplingRate, {sf::SoundChannel::Mono});
+  start_producer(0);
+}
+
+void PreviewStream::stop_preview()
+{
+  // The audio thread has to stop before the producer it reads from
+  stop();
+  stop_producer();
+  convolver.clear();
+}
+
+bool PreviewStream::is_playing() const
+{
+  return getStatus() == sf::SoundSource::Status::Playing;
+}
+
+size_t PreviewStream::get_underruns() const
+{
+  return underruns.load();
+}
+
+bool PreviewStream::onGetData(Chunk &data)
+{
+  // Read finished first, if it was set every sample was already pushed
+  bool done = finished.load(memory_order_acquire);
+  size_t count = ring.pop(chunk.data(), CHUNK_SIZE);
+  if(count == 0 && done)
+  {
+    return false;
+  }
+
+  if(count < CHUNK_SIZE)
+  {
+    fill(chunk.begin() + count, chunk.end(), 0);
+    if(!done)
+    {
+      ++underruns;
+    }
+  }
+
+  data.samples = chunk.data();
+  data.sampleCount = CHUNK_SIZE;
+
+  return true;
+}
+
+void PreviewStream::onSeek(sf::Time timeOffset)
+{
+  // The convolution restarts at the new position, reverb of what came
+  // before it isn't heard
+  stop_producer();
+  start_producer(static_cast<size_t>(timeOffset.asSeconds()
+        * static_cast<float>(currentSamplingRate)));
+}
+
+void PreviewStream::start_producer(const size_t &position)
+{
+  ring.clear();
+  finished = true;
+
+  if(samples.size() == 0 || response.size() == 0)
+  {
+    static_cast<void>(Logger(Logger::L_WRN
+          , "Preview needs both a wave and a scene response"));
+    return;
+  }
+
+  // The tail of the response is convolved by the convolver's background
+  // thread so the producer only ever convolves the head
+  convolver.set_impulse_response(response.front(), response.size(), true);
+  producerPosition = position;
+  finished = false;
+  producing = true;
+  producer = thread(&PreviewStream::run_producer, this);
+}
+
+void PreviewStream::stop_producer()
+{
+  producing = false;
+  if(producer.joinable())
+  {
+    producer.join();
+  }
+}
+
+void PreviewStream::run_producer()
+{
+  const size_t blockSize = convolver.get_block_size();
+  // Play until the tail of the response has rung out
+  const size_t length = samples.size() + response.size() - 1;
+  vector<float> block(blockSize);
+  vector<int16_t> pcm(blockSize);
+
+  while(producing && producerPosition < length)
+  {
+    // The ring's capacity is rounded up, so how far ahead the producer is
+    // is checked against RING_SIZE instead
+    if(ring.get_available() + blockSize > RING_SIZE)
+    {
+      this_thread::sleep_for(chrono::milliseconds(1));
+      continue;
+    }
+
+    for(size_t i = 0; i < blockSize; ++i)
+    {
+      size_t index = producerPosition + i;
+      block[i] = (index < samples.size()) ? samples.at(index) : 0.f;
+    }
+
+    convolver.process_block(block.data(), block.data());
+
+    for(size_t i = 0; i < blockSize; ++i)
+    {
+      float sample = min(max(block[i], -1.f), 1.f);
+      pcm[i] = static_cast<int16_t>(sample * 32767.f);
+    }
+
+    ring.push(pcm.data(), blockSize);
+    producerPosition += blockSize;
+  }
+
+  finished.store(true, memory_order_release);
+}
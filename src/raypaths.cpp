@@ -0,0 +1,147 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   raypaths.cpp
+ *
+ *  \brief
+ *    Implementation of the flat storage of traced ray paths
+ */
+
+#include "raypaths.h"
+
+#include <cmath>
+
+using namespace std;
+
+RayPaths::RayPaths()
+  : pathOffsets(1, 0u)
+{
+}
+
+RayPaths::~RayPaths() { }
+
+void RayPaths::clear(const size_t &_bandCount)
+{
+  points.clear();
+  pathOffsets.assign(1, 0u);
+  segmentLevels.clear();
+  bands.clear();
+  bandCount = _bandCount;
+  highlights.clear();
+}
+
+void RayPaths::reserve(const size_t &pathCount, const size_t &pointCount)
+{
+  points.reserve(pointCount);
+  pathOffsets.reserve(pathCount + 1);
+  segmentLevels.reserve(pointCount);
+  bands.reserve(pathCount * bandCount);
+  highlights.reserve(pathCount);
+}
+
+void RayPaths::add_path(const Vec2 *_points, const float *levels
+    , const size_t &pointCount, const BandEnergy &energy)
+{
+  points.insert(points.end(), _points, _points + pointCount);
+  pathOffsets.push_back(static_cast<uint32_t>(points.size()));
+  segmentLevels.insert(segmentLevels.end(), levels, levels + pointCount - 1);
+  bands.insert(bands.end(), energy.value, energy.value + bandCount);
+  highlights.push_back(PH_NONE);
+}
+
+void RayPaths::append(const RayPaths &other)
+{
+  const uint32_t pointBase = static_cast<uint32_t>(points.size());
+
+  points.insert(points.end(), other.points.begin(), other.points.end());
+  segmentLevels.insert(segmentLevels.end(), other.segmentLevels.begin()
+      , other.segmentLevels.end());
+  bands.insert(bands.end(), other.bands.begin(), other.bands.end());
+  highlights.insert(highlights.end(), other.highlights.begin()
+      , other.highlights.end());
+
+  for(size_t i = 1; i < other.pathOffsets.size(); ++i)
+  {
+    pathOffsets.push_back(pointBase + other.pathOffsets[i]);
+  }
+}
+
+size_t RayPaths::size() const
+{
+  return highlights.size();
+}
+
+bool RayPaths::empty() const
+{
+  return highlights.empty();
+}
+
+size_t RayPaths::get_point_total() const
+{
+  return points.size();
+}
+
+size_t RayPaths::get_band_count() const
+{
+  return bandCount;
+}
+
+size_t RayPaths::get_point_count(const size_t &path) const
+{
+  return pathOffsets[path + 1] - pathOffsets[path];
+}
+
+size_t RayPaths::get_segment_count(const size_t &path) const
+{
+  return get_point_count(path) - 1;
+}
+
+const Vec2 *RayPaths::get_points(const size_t &path) const
+{
+  return points.data() + pathOffsets[path];
+}
+
+float RayPaths::get_segment_length(const size_t &path
+    , const size_t &segment) const
+{
+  const Vec2 *pathPoints = get_points(path);
+  float a = pathPoints[segment + 1].x - pathPoints[segment].x;
+  float b = pathPoints[segment + 1].y - pathPoints[segment].y;
+
+  return sqrt(a * a + b * b);
+}
+
+float RayPaths::get_segment_level(const size_t &path
+    , const size_t &segment) const
+{
+  return segmentLevels[pathOffsets[path] - path + segment];
+}
+
+const float *RayPaths::get_bands(const size_t &path) const
+{
+  return bands.data() + path * bandCount;
+}
+
+float RayPaths::get_energy_average(const size_t &path) const
+{
+  const float *pathBands = get_bands(path);
+
+  float average = 0.f;
+  for(size_t i = 0; i < bandCount; ++i)
+  {
+    average += pathBands[i];
+  }
+
+  return (bandCount == 0) ? 1 : average / bandCount;
+}
+
+RayPaths::PATH_HIGHLIGHT RayPaths::get_highlight(const size_t &path) const
+{
+  return static_cast<PATH_HIGHLIGHT>(highlights[path]);
+}
+
+void RayPaths::set_highlight(const size_t &path
+    , const PATH_HIGHLIGHT &highlight)
+{
+  highlights[path] = static_cast<uint8_t>(highlight);
+}
@@ -0,0 +1,215 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   receiver.cpp
+ *
+ *  \brief
+ *    Implementation of volumetric receivers and the energy histograms they
+ *    record
+ */
+
+#include "receiver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "filter.h"
+#include "listener2.h"
+
+using namespace std;
+
+// Centimeters per second
+const float SPEED_OF_SOUND = 34300.f;
+
+EnergyHistogram::EnergyHistogram() { }
+
+EnergyHistogram::~EnergyHistogram() { }
+
+void EnergyHistogram::clear(const size_t &_bandCount, const float &_binWidth)
+{
+  bins.clear();
+  bandCount = _bandCount;
+  binWidth = _binWidth;
+}
+
+void EnergyHistogram::add(const float &time, const BandEnergy &energy
+    , const float &scale)
+{
+  size_t bin = static_cast<size_t>(time / binWidth);
+  if(bin >= bins.size())
+  {
+    bins.resize(bin + 1);
+  }
+
+  bins[bin].add_scaled(energy, scale);
+}
+
+void EnergyHistogram::merge(const EnergyHistogram &other)
+{
+  if(bins.size() < other.bins.size())
+  {
+    bins.resize(other.bins.size());
+  }
+
+  for(size_t i = 0; i < other.bins.size(); ++i)
+  {
+    bins[i] += other.bins[i];
+  }
+}
+
+size_t EnergyHistogram::size() const
+{
+  return bins.size();
+}
+
+bool EnergyHistogram::empty() const
+{
+  return bins.empty();
+}
+
+size_t EnergyHistogram::get_band_count() const
+{
+  return bandCount;
+}
+
+float EnergyHistogram::get_bin_width() const
+{
+  return binWidth;
+}
+
+const BandEnergy &EnergyHistogram::get_bin(const size_t &bin) const
+{
+  return bins[bin];
+}
+
+AudioBuffer EnergyHistogram::synthesise_impulse_response(
+    const BandGrid &grid, const unsigned &samplingRate) const
+{
+  AudioBuffer response;
+
+  auto get_loudest_band = [&](const BandEnergy &energy)
+  {
+    float loudest = 0.f;
+    for(size_t i = 0; i < bandCount; ++i)
+    {
+      loudest = max(loudest, energy[i]);
+    }
+    return loudest;
+  };
+
+  float loudest = 0.f;
+  for(const BandEnergy &bin : bins)
+  {
+    loudest = max(loudest, get_loudest_band(bin));
+  }
+
+  if(loudest <= 0.f || samplingRate == 0)
+  {
+    return response;
+  }
+
+  // Drop the bins after the response has decayed by 60dB
+  size_t binCount = bins.size();
+  while(get_loudest_band(bins[binCount - 1]) < loudest * 1e-6f)
+  {
+    --binCount;
+  }
+
+  const float binSamples = binWidth * samplingRate;
+  const size_t sampleCount = static_cast<size_t>(ceil(binCount * binSamples));
+
+  // Random signs keep the energy of every noise sample at exactly 1
+  AudioBuffer noise;
+  noise.resize_uninitialized(sampleCount);
+  uint32_t random = 0x2545F491u;
+  for(size_t i = 0; i < sampleCount; ++i)
+  {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    noise[i] = (random & 1u) ? 1.f : -1.f;
+  }
+
+  response.resize(sampleCount);
+  // Every band is written over the same buffer, the band pass filters it in
+  // place
+  AudioBuffer samples;
+  samples.resize_uninitialized(sampleCount);
+  // The bands are an octave wide
+  const float quality = sqrt(2.f);
+  const float PI = 4.f * atan(1.f);
+  for(size_t band = 0; band < bandCount && band < grid.size(); ++band)
+  {
+    float frequency = grid.get_frequency(band);
+    if(frequency >= samplingRate / 2.f)
+    {
+      continue;
+    }
+
+    for(size_t i = 0; i < sampleCount; ++i)
+    {
+      size_t bin = min(static_cast<size_t>(i / binSamples), binCount - 1);
+      // Spread the energy of a bin across its samples
+      samples[i] = noise.at(i) * sqrt(bins[bin][band] / binSamples);
+    }
+
+    // Make up for the energy of the noise outside of the band, which is all
+    // but the filter's bandwidth of pi * f / 2Q
+    float bandwidth = PI * frequency / (2.f * quality);
+    BandPass filter(frequency, quality, static_cast<float>(samplingRate));
+    filter.update_values();
+    filter.set_gain(sqrt(samplingRate / 2.f / bandwidth));
+    filter.apply_filter(samples);
+
+    response += samples;
+  }
+
+  static_cast<void>(Logger(Logger::L_MSG, "Synthesised impulse response of "
+        + to_string(sampleCount) + " samples from " + to_string(binCount)
+        + " histogram bins"));
+
+  return response;
+}
+
+float VolumeReceiver::add_segment(const Vec2 &begin, const Vec2 &end
+    , const float &distance, const BandEnergy &energy
+    , EnergyHistogram &histogram) const
+{
+  Vec2 delta = end - begin;
+  float length = sqrt(delta.x * delta.x + delta.y * delta.y);
+  if(length <= 0.f)
+  {
+    return 0.f;
+  }
+
+  // Find where the segment enters and leaves the circle
+  Vec2 direction = delta / length;
+  Vec2 toCenter = center - begin;
+  float closest = toCenter.x * direction.x + toCenter.y * direction.y;
+  float missSquared = toCenter.x * toCenter.x + toCenter.y * toCenter.y
+    - closest * closest;
+  if(missSquared < radius * radius)
+  {
+    float halfChord = sqrt(radius * radius - missSquared);
+    float enter = max(0.f, closest - halfChord);
+    float leave = min(length, closest + halfChord);
+    if(leave > enter)
+    {
+      float time = (distance + (enter + leave) / 2.f / scalar)
+        / SPEED_OF_SOUND;
+      // Energy density is the length within the circle over its area, both
+      // in centimeters
+      float weight = rayEnergy * (leave - enter) * scalar
+        / (4.f * atan(1.f) * radius * radius);
+      if(listener)
+      {
+        weight *= listener->get_directional_gain(begin - end);
+      }
+
+      histogram.add(time, energy, weight);
+    }
+  }
+
+  return length / scalar;
+}
@@ -0,0 +1,230 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   reverb.cpp
+ *
+ *  \brief
+ *    Implementation of the feedback delay network used for artificial reverb
+ */
+
+#include "reverb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "helper.h"
+
+using namespace std;
+
+FeedbackDelayNetwork::FeedbackDelayNetwork() { }
+
+FeedbackDelayNetwork::~FeedbackDelayNetwork() { }
+
+/*
+ *  Each band loses 60 dB over its T60, so a line of d samples scales it by
+ *    g = 10^(-3 * d / (samplingRate * T60))
+ *
+ *  The lowest band's gain is applied directly, then a high shelf at the
+ *  crossover between each pair of bands steps the gain from one band to the
+ *  next. A shelf is 1 below its crossover and its gain above, so the
+ *  cascade makes a staircase through every band's gain.
+ */
+void FeedbackDelayNetwork::set_network(const CArray<uint16_t> &delays
+    , const CoefficentArray &t60s, const float &_samplingRate)
+{
+  lines.clear();
+  minDelay = 0;
+  tailLength = 0;
+
+  samplingRate = _samplingRate;
+  if(samplingRate == 0 || std::isnan(samplingRate))
+  {
+    samplingRate = 44100;
+  }
+
+  if(delays.size() == 0 || t60s.size() == 0)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "A feedback delay network needs delays and bands to be built"));
+    return;
+  }
+
+  const float PI = 4.f * atan(1);
+  float maxT60 = 0.f;
+  size_t maxDelay = 0;
+  vector<float> gains(t60s.size());
+  for(size_t i = 0; i < delays.size(); ++i)
+  {
+    size_t delay = delays.at(i);
+    if(delay == 0)
+    {
+      continue;
+    }
+
+    LINE line;
+    line.buffer.assign(delay, 0.f);
+    for(size_t j = 0; j < t60s.size(); ++j)
+    {
+      float t60 = min(max(t60s.at(j).y, 0.001f), MAX_T60);
+      maxT60 = max(maxT60, t60);
+      gains[j] = pow(10.f, -3.f * delay / (samplingRate * t60));
+    }
+    line.gain = gains[0];
+
+    for(size_t j = 1; j < t60s.size(); ++j)
+    {
+      float crossover = sqrt(t60s.at(j - 1).x * t60s.at(j).x);
+      crossover = min(crossover, 0.45f * samplingRate);
+
+      // RBJ high shelf with a slope of 1
+      float A = sqrt(gains[j] / gains[j - 1]);
+      float omega = 2.f * PI * crossover / samplingRate;
+      float cosOmega = cos(omega);
+      float alpha = sin(omega) / 2.f * sqrt(2.f);
+      float root = 2.f * sqrt(A) * alpha;
+
+      float a0 = (A + 1.f) - (A - 1.f) * cosOmega + root;
+      SHELF shelf;
+      shelf.b0 = A * ((A + 1.f) + (A - 1.f) * cosOmega + root) / a0;
+      shelf.b1 = -2.f * A * ((A - 1.f) + (A + 1.f) * cosOmega) / a0;
+      shelf.b2 = A * ((A + 1.f) + (A - 1.f) * cosOmega - root) / a0;
+      shelf.a1 = 2.f * ((A - 1.f) - (A + 1.f) * cosOmega) / a0;
+      shelf.a2 = ((A + 1.f) - (A - 1.f) * cosOmega - root) / a0;
+      line.shelves.push_back(shelf);
+    }
+
+    minDelay = (minDelay == 0) ? delay : min(minDelay, delay);
+    maxDelay = max(maxDelay, delay);
+    lines.push_back(line);
+  }
+
+  tailLength = static_cast<size_t>(ceil(maxT60 * samplingRate)) + maxDelay;
+}
+
+size_t FeedbackDelayNetwork::get_line_count() const
+{
+  return lines.size();
+}
+
+size_t FeedbackDelayNetwork::get_tail_length() const
+{
+  return tailLength;
+}
+
+void FeedbackDelayNetwork::apply_filter(AudioBuffer &samples)
+{
+  if(samples.size() == 0)
+  {
+    return;
+  }
+
+  reset();
+  samples.resize(samples.size() + tailLength);
+  process_block(samples.data(), samples.data(), samples.size());
+}
+
+void FeedbackDelayNetwork::reset()
+{
+  for(LINE &line : lines)
+  {
+    fill(line.buffer.begin(), line.buffer.end(), 0.f);
+    line.head = 0;
+    for(SHELF &shelf : line.shelves)
+    {
+      shelf.x1 = shelf.x2 = shelf.y1 = shelf.y2 = 0.f;
+    }
+  }
+}
+
+void FeedbackDelayNetwork::process_block(const float *input, float *output
+    , const size_t &count)
+{
+  if(lines.empty())
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Attempted to use a feedback delay network that wasn't built"));
+    if(output != input)
+    {
+      memcpy(output, input, count * sizeof(float));
+    }
+    return;
+  }
+
+  // Nothing written into a line comes back out until the line has been
+  // read through, so blocks up to the shortest line are run whole
+  for(size_t done = 0; done < count; done += minDelay)
+  {
+    run_lines(input + done, output + done, min(minDelay, count - done));
+  }
+}
+
+void FeedbackDelayNetwork::run_lines(const float *input, float *output
+    , const size_t &count)
+{
+  const size_t lineCount = lines.size();
+  lineOutput.resize(lineCount * count);
+  mix.assign(count, 0.f);
+
+  for(size_t i = 0; i < lineCount; ++i)
+  {
+    LINE &line = lines[i];
+    float *out = lineOutput.data() + i * count;
+
+    size_t first = min(count, line.buffer.size() - line.head);
+    memcpy(out, line.buffer.data() + line.head, first * sizeof(float));
+    memcpy(out + first, line.buffer.data(), (count - first) * sizeof(float));
+
+    for(size_t n = 0; n < count; ++n)
+    {
+      out[n] *= line.gain;
+    }
+    for(SHELF &shelf : line.shelves)
+    {
+      for(size_t n = 0; n < count; ++n)
+      {
+        float x = out[n];
+        float y = shelf.b0 * x + shelf.b1 * shelf.x1 + shelf.b2 * shelf.x2
+          - shelf.a1 * shelf.y1 - shelf.a2 * shelf.y2;
+        shelf.x2 = shelf.x1;
+        shelf.x1 = x;
+        shelf.y2 = shelf.y1;
+        shelf.y1 = y;
+        out[n] = y;
+      }
+    }
+
+    for(size_t n = 0; n < count; ++n)
+    {
+      mix[n] += out[n];
+    }
+  }
+
+  // The Householder matrix I - 2/N * 11^T reflects every line off the sum
+  // of them all, mixing each line into every other while keeping the energy
+  // of the lines
+  const float reflection = 2.f / static_cast<float>(lineCount);
+  for(size_t i = 0; i < lineCount; ++i)
+  {
+    LINE &line = lines[i];
+    const float *out = lineOutput.data() + i * count;
+    size_t first = min(count, line.buffer.size() - line.head);
+    float *head = line.buffer.data() + line.head;
+    for(size_t n = 0; n < first; ++n)
+    {
+      head[n] = out[n] - reflection * mix[n] + input[n];
+    }
+    for(size_t n = first; n < count; ++n)
+    {
+      line.buffer[n - first] = out[n] - reflection * mix[n] + input[n];
+    }
+    line.head = (line.head + count) % line.buffer.size();
+  }
+
+  // Written last as the output may be the input
+  const float scale = 1.f / static_cast<float>(lineCount);
+  for(size_t n = 0; n < count; ++n)
+  {
+    output[n] = mix[n] * scale;
+  }
+}
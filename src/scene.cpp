@@ -9,6 +9,7 @@
 
 #include "scene.h"
 
+#include <SFML/Graphics/PrimitiveType.hpp>
 #include <SFML/System/Sleep.hpp>
 #include <cmath>
 #include <numeric>
@@ -22,6 +23,7 @@
 
 #include "wave.h"
 #include "filter.h"
+#include "reverb.h"
 
 #include "parsedata.h"
 #include "generator.h"
@@ -29,7 +31,8 @@
 using namespace std;
 
 /*!
- *  Generate a given number of coprime values
+ *  Generate a given number of values that are all coprime with each other,
+ *  alternating above and below the base value so they stay close to it
  *
  *  \param value
  *    The base value
@@ -58,18 +61,27 @@ CArray<uint16_t> generate_nearest_coprimes(const uint16_t &value, const uint8_t
   uint16_t negValue = value;
   for(uint16_t i = 1; i < numOfValues; ++i)
   {
-    uint16_t gcd = 0;
-    bool positive = numOfValues % 2;
-    // Keep adding or subtracing 1 till we reach a coprime and then add it to
-    // the coprime array
-    while(gcd != 1)
+    bool positive = i % 2;
+    bool coprime = false;
+    uint16_t candidate = value;
+    // Keep adding or subtracing 1 till we reach a value coprime with every
+    // value so far and then add it to the coprime array
+    while(!coprime)
     {
-      gcd = std::gcd(value
-          , ((numOfValues) 
-            ? ++posValue 
-            : --negValue));
+      // Values below 2 are coprime with everything but too short to use
+      if(!positive && negValue <= 2)
+      {
+        positive = true;
+      }
+      candidate = positive ? ++posValue : --negValue;
+
+      coprime = true;
+      for(uint16_t j = 0; j < i && coprime; ++j)
+      {
+        coprime = std::gcd(candidate, returnArray[j]) == 1;
+      }
     }
-    returnArray[i] = (numOfValues ? posValue : negValue);
+    returnArray[i] = candidate;
   }
 
   return returnArray;
@@ -96,6 +108,34 @@ bool Scene::is_open() const
   return open;
 }
 
+void Scene::set_ray_generation_info(const RayGenerationInfo &info)
+{
+  rayGenerationInfo = info;
+}
+
+const RayGenerationInfo &Scene::get_ray_generation_info() const
+{
+  return rayGenerationInfo;
+}
+
+void Scene::set_render_mode(const RENDER_MODE &mode)
+{
+  if(renderMode == mode)
+  {
+    return;
+  }
+
+  renderMode = mode;
+  // Rebuild the filters for the new mode on the next render
+  filterBank.clear();
+  convolver.set_impulse_response(AudioBuffer());
+}
+
+const Scene::RENDER_MODE &Scene::get_render_mode() const
+{
+  return renderMode;
+}
+
 Vec2 Scene::open_scene(const string &fileName, const bool &ignoreInputDir)
 {
   clear();
@@ -137,33 +177,124 @@ Vec2 Scene::open_scene(const string &fileName, const bool &ignoreInputDir)
   relativeScalar = Vec2{roomData.z, roomData.w};
 
   objects = convert_DataMap_to_Object(dataMap, relativePos, relativeScalar);
-  audioRayVec = generate_audio_rays_from_scene(objects, relativePos
-      , relativeSize, relativeScalar);
+
+  // The bands, edge table and grid are built once per scene and then shared
+  // by every traced ray
+  bandGrid.build(objects);
+  edgeTable.compile(objects, relativePos, relativeSize, relativeScalar
+      , bandGrid);
+  if(rayGenerationInfo.useCollisionGrid)
+  {
+    collisionGrid.build(edgeTable);
+  }
+
+  rayPaths = generate_audio_rays_from_scene(objects, edgeTable
+      , relativeScalar, rayGenerationInfo, &collisionGrid, &histogram);
 
   return relativeSize;
 }
 
 void Scene::apply_filter_to_wave(WaveFile &wave)
 {
-  unsigned incomingSamplingRate = wave.get_sampling_rate();
-  if((filters.size() == 0) || currentSamplingRate != incomingSamplingRate)
+  AudioBuffer &samples = wave.get_samples();
+  if(samples.size() == 0)
   {
-    if(filters.size() > 0)
-    {
-      filters.clear();
-    }
-    currentSamplingRate = incomingSamplingRate;
+    return;
+  }
+
+  bool convolve = prepare_scene_filter(wave.get_sampling_rate());
+  Filter &filter = convolve ? static_cast<Filter &>(convolver) : filterBank;
+  filter.reset();
+
+  // The samples are grown to the length of the render once and filtered in
+  // place, the silence after the input flushes out the tail
+  const size_t length = get_render_length(samples.size(), convolve);
+  samples.resize(length);
+
+  static_cast<void>(Logger(Logger::L_MSG, "Rendering " + to_string(length)
+        + " samples through the scene"));
+
+  float *data = samples.data();
+  const size_t whole = length - length % STREAM_BLOCK_SIZE;
+  for(size_t begin = 0; begin < whole; begin += STREAM_BLOCK_SIZE)
+  {
+    filter.process_block(data + begin, data + begin, STREAM_BLOCK_SIZE);
+  }
+
+  // The filters only take whole blocks so the last one is padded
+  if(whole < length)
+  {
+    vector<float> block(STREAM_BLOCK_SIZE, 0.f);
+    copy(data + whole, data + length, block.begin());
+    filter.process_block(block.data(), block.data(), STREAM_BLOCK_SIZE);
+    copy(block.begin(), block.begin() + (length - whole), data + whole);
+  }
+}
+
+void Scene::render_wave_file(WaveReader &input, WaveWriter &output)
+{
+  bool convolve = prepare_scene_filter(input.get_sampling_rate());
+  Filter &filter = convolve ? static_cast<Filter &>(convolver) : filterBank;
+  filter.reset();
+
+  // Keep going past the input until the tail of the scene has played
+  const size_t length = get_render_length(input.get_sample_count(), convolve);
+
+  static_cast<void>(Logger(Logger::L_MSG, "Streaming " + to_string(length)
+        + " samples through the scene"));
+
+  vector<float> block(STREAM_BLOCK_SIZE);
+  for(size_t written = 0; written < length; written += STREAM_BLOCK_SIZE)
+  {
+    size_t read = input.read_block(block.data(), STREAM_BLOCK_SIZE);
+    fill(block.begin() + read, block.end(), 0.f);
+
+    filter.process_block(block.data(), block.data(), STREAM_BLOCK_SIZE);
+    output.write_block(block.data(), min(STREAM_BLOCK_SIZE, length - written));
+  }
+}
+
+size_t Scene::get_render_length(const size_t &inputLength
+    , const bool &convolve) const
+{
+  if(convolve)
+  {
+    size_t responseLength = convolver.get_length();
+    return inputLength + ((responseLength > 0) ? responseLength - 1 : 0);
+  }
+
+  return inputLength + filterBank.get_tail_length();
+}
+
+bool Scene::prepare_scene_filter(const unsigned &samplingRate)
+{
+  // A volumetric listener has a single impulse response for the whole scene
+  bool convolve = !histogram.empty() || renderMode == RM_CONVOLUTION;
+  if((convolve ? convolver.get_length() == 0
+        : filterBank.get_band_count() == 0)
+      || currentSamplingRate != samplingRate)
+  {
+    currentSamplingRate = samplingRate;
     generate_scene_filter();
   }
 
-  CArray<float> output;
-  for(size_t i = 0; i < filters.size(); ++i)
+  return convolve;
+}
+
+const AudioBuffer &Scene::get_impulse_response(const unsigned &samplingRate)
+{
+  if(convolver.get_length() == 0 || currentSamplingRate != samplingRate)
   {
-    CArray<float> input(wave.get_samples());
-    filters[i].apply_filter(input);
-    output += input;
+    // Filters built for another rate are rebuilt on the next render
+    if(currentSamplingRate != samplingRate)
+    {
+      filterBank.clear();
+    }
+    currentSamplingRate = samplingRate;
+    convolver.set_impulse_response(build_impulse_response());
   }
-  wave.get_samples() = output;
+
+  return convolver.get_impulse_response();
 }
 
 /*!
@@ -173,9 +304,10 @@ void Scene::apply_filter_to_wave(WaveFile &wave)
  *    -6.908 is the ln(1000) which represents the drop to -60dB which is
  *    1/1000th the amplitude of the original signal.
  *
- *    We will use a mix of comb and lowpass filters to creat artifical
- *    reverberation. To avoid robotic sounding delay we will use Schroeder
- *    Reverb with 10 (og: 4) parallel delay lines with coprime delay lengths
+ *    We will use a feedback delay network to creat artifical reverberation.
+ *    To avoid robotic sounding delay it has 10 (og: 4) delay lines with
+ *    coprime delay lengths, each absorbing every band by as much as the room
+ *    would over the length of the line
  *
  *    T60 is taken from the Sabine formula for RT_60 = (0.161 * V) / A
  *    V = room volume in m^3
@@ -194,86 +326,73 @@ void Scene::apply_t60_to_wave(WaveFile &wave)
     currentSamplingRate = wave.get_sampling_rate();
   }
 
-  // Using an audio ray to track absorbtion as it has all the built in
-  // functionality needed
-  AudioRay absorbtionRay(nullptr, 0, Barrier::get_coefficent(Barrier::C_WALL)
-      , {0.f, 0.f}, {0.f, 0.f});
-  absorbtionRay.scale_amp(2.f * relativeSize.x 
-      + 2.f * relativeSize.y);
-  for(size_t i = 0; i < absorbtionRay.get_amp().size(); ++i)
+  // NOTE: Each pixel is a centimeter atm, Sabine is worked out in meters
+  float scalar = (relativeScalar.x > relativeScalar.y) 
+    ? relativeScalar.x : relativeScalar.y;
+  float width = relativeSize.x / scalar / 100.f;
+  float height = relativeSize.y / scalar / 100.f;
+  float area = width * height;
+
+  // The absorbtion of each band in Sabins, starting with the walls of the
+  // room
+  CoefficentArray bands(Barrier::get_coefficent(Barrier::C_WALL));
+  for(size_t i = 0; i < bands.size(); ++i)
   {
-    Logger(Logger::L_MSG, "T60 AR" + to_string(i) + ": " 
-        + to_string(absorbtionRay.get_amp().at(i).y));
+    bands[i].y *= 2.f * width + 2.f * height;
   }
 
-  float area = relativeSize.x * relativeSize.y;
-
   for(Object *object : objects)
   {
     Vec2 size = object->get_size();
-    absorbtionRay.scale_and_add_to_amp(object->get_absortion_coefficent()
-        , 2.f * size.x + 2.f *size.y);
+    float perimeter = (2.f * size.x + 2.f * size.y) / scalar / 100.f;
+    const CoefficentArray &coefficents = object->get_absortion_coefficent();
+    // Bands the walls don't have can't be given a T60 so they are skipped
+    for(size_t i = 0; i < coefficents.size(); ++i)
+    {
+      for(size_t j = 0; j < bands.size(); ++j)
+      {
+        if(bands[j].x == coefficents.at(i).x)
+        {
+          bands[j].y += coefficents.at(i).y * perimeter;
+        }
+      }
+    }
   }
 
-  Logger(Logger::L_MSG, "T60 AMP AVERAGE: " 
-      + to_string(absorbtionRay.get_amp_average()));
-
-  CArray<Vec2> bands(absorbtionRay.get_amp());
   for(size_t i = 0; i < bands.size(); ++i)
   {
-    // e^(-6.908)/T60
-    bands[i].y = exp((-6.908f) 
-        / ((0.161f * area) / (bands[i].y)));
+    bands[i].y = (0.161f * area) / bands[i].y;
     Logger(Logger::L_MSG, "T60 BAND " + to_string(i) + ": " 
         + to_string(bands[i].y));
   }
 
+  // delay is in samples and uses the larger wall distance to calculate the
+  // delay
+  float delaySamples = max(width, height) / 343.f * currentSamplingRate;
+  uint16_t delayTime = static_cast<uint16_t>(
+      min(max(delaySamples, 2.f), 60000.f));
 
-  // TODO: Handle extra space needed for samples still reverberating 
-  // i.e. if a given wav is too short and we need more samples to fully
-  // show reverberance
-  
-  // NOTE: Each pixel is a centimeter atm
-
-  // delay is in ms and uses the larger wall distance to calculate the ms delay
-  uint16_t delayTime = (relativeSize.x > relativeSize.y)
-    ? relativeSize.x / 34300.f * wave.get_sampling_rate()
-    : relativeSize.y / 34300.f * wave.get_sampling_rate();
-
-  CArray<float> output;
   const size_t delayCount = 10;
   CArray<uint16_t> delays = generate_nearest_coprimes(delayTime, delayCount);
   for(size_t i = 0; i < delayCount; ++i)
   {
     static_cast<void>(Logger(Logger::L_MSG, "T60 DelayTime " + to_string(i)
           + ": " + to_string(delays[i])));
-
-    CArray<float> input(wave.get_samples());
-    
-    size_t bandSize = bands.size();
-    Equalizer t60EQ(bandSize, currentSamplingRate, delays[i]);
-    for(size_t j = 0; j < bandSize; ++j)
-    {
-      t60EQ.add_coefficent(bands[j].x, bands[j].y / delayCount, j);
-    }
-
-    t60EQ.apply_filter(input);
-    output += input;
   }
 
-  // Overwrite samples from output into wave object
-  wave.get_samples() = output;
+  FeedbackDelayNetwork reverb;
+  reverb.set_network(delays, bands, currentSamplingRate);
+  reverb.apply_filter(wave.get_samples());
 }
 
 void Scene::draw(sf::RenderWindow &window)
 {
-  for(vector<AudioRay *> audioRays : audioRayVec)
+  if(rayVertices.empty() && !rayPaths.empty())
   {
-    for(AudioRay *audioRay : audioRays)
-    {
-      audioRay->draw(window);
-    }
+    build_ray_vertices();
   }
+  window.draw(rayVertices.data(), rayVertices.size()
+      , sf::PrimitiveType::Lines);
 
   for(Object *object : objects)
   {
@@ -282,79 +401,186 @@ void Scene::draw(sf::RenderWindow &window)
 }
 
 // TODO: Add comb delay and allpass 
-void Scene::add_bandpass_reverb_filter(const uint16_t &delay
-    , const float &frequency, const size_t &bandCount
-    , const float &coefficent, const float &outputScale
-    , const CArray<float> &input, CArray<float> &output)
+
+void Scene::generate_scene_filter()
 {
-  CArray<float> delayLine(input);
-  float bandwidth = currentSamplingRate / 2.f / bandCount;
-  BandPass band(frequency, 0.1f);
-  band.set_sampling_rate(currentSamplingRate);
-  band.update_values();
-  band.set_gain(1.f);
-  band.apply_filter(delayLine);
-
-  // Ensure the output and delayLine size account for the added delay
-  delayLine.resize(delayLine.size() + delay);
-  if(output.size() < delayLine.size())
-  {
-    output.resize(delayLine.size());
-  }
-
-  // Go through samples and adjust based on T60 calculation
-  float echoOutput = 0.f;
-  // Ignore the first [delayTime] number of samples as they will be 0
-  for(int i = delay; i < delayLine.size(); ++i)
-  {
-    float echo = delayLine[i-delay];
-    float lowpassEcho = (echo + echoOutput) * 0.5f;
-    echoOutput = lowpassEcho;
-    float outputValue = lowpassEcho * coefficent;
-
-    // As we are adding another sample to an existing sample we must scale
-    // it down so that it accuratley represents the new mixxed signal
-    delayLine[i] = (delayLine[i] + outputValue) * 0.5f;
-    output[i] += outputValue * outputScale;
-    if(output[i] > 1.f || output[i] < -1.f || output[i] == NAN)
+  filterBank.clear();
+  convolver.set_impulse_response(AudioBuffer());
+
+  if(!histogram.empty() || renderMode == RM_CONVOLUTION)
+  {
+    convolver.set_impulse_response(build_impulse_response());
+    return;
+  }
+
+  // Every path shares the same band split of the input
+  size_t bandCount = rayPaths.get_band_count();
+  filterBank = FilterBank(bandCount, currentSamplingRate);
+  for(size_t j = 0; j < bandCount; ++j)
+  {
+    filterBank.set_frequency(j, bandGrid.get_frequency(j));
+  }
+
+  vector<float> gains(bandCount);
+  for(size_t i = 0; i < rayPaths.size(); ++i)
+  {
+    size_t segmentCount = rayPaths.get_segment_count(i);
+    const float *bands = rayPaths.get_bands(i);
+
+    for(size_t j = 0; j < bandCount; ++j)
     {
-      Logger(Logger::L_WRN, "ERROR INVALID OUTPUT " + to_string(output[i]));
+      // Divide the coefficent by the number of rays to ensure it doesn't get
+      // overloaded
+      gains[j] = bands[j] / segmentCount;
     }
+    filterBank.add_tap(get_path_delay(i), gains.data());
   }
 }
 
-void Scene::generate_scene_filter()
+AudioBuffer Scene::build_impulse_response() const
 {
-  filters.clear();
+  if(histogram.empty())
+  {
+    return build_path_impulse_response();
+  }
 
-  // Resize the filter to match the size of the number of AudioRays
-  filters.resize(audioRayVec.size());
+  AudioBuffer response = histogram.synthesise_impulse_response(bandGrid
+      , currentSamplingRate);
 
-  size_t i = 0;
-  for(vector<AudioRay *> &audioRays : audioRayVec)
+  // Normalize the response to unit energy so the output is as loud as the
+  // input no matter how many rays were traced
+  float energy = 0.f;
+  for(size_t i = 0; i < response.size(); ++i)
+  {
+    energy += response.at(i) * response.at(i);
+  }
+  if(energy > 0.f)
   {
-    float distance = 0.f;
-    float scalar = (relativeScalar.x > relativeScalar.y) 
-      ? relativeScalar.x : relativeScalar.y;
-    // NOTE: each pixel is assumed to be a centimeter in this simulation atm
-    for(AudioRay *audioRay : audioRays)
-    { 
-      distance += audioRay->get_distance() / scalar;
+    float scale = 1.f / sqrt(energy);
+    for(size_t i = 0; i < response.size(); ++i)
+    {
+      response[i] *= scale;
     }
-    unsigned delay = distance / 34300.f * currentSamplingRate;
+  }
 
-    const CArray<Vec2> &array = audioRays.back()->get_amp();
-    filters[i] = Equalizer(array.size(), currentSamplingRate, delay);
+  return response;
+}
 
-    for(size_t j = 0; j < array.size(); ++j)
+unsigned Scene::get_path_delay(const size_t &path) const
+{
+  float distance = 0.f;
+  float scalar = (relativeScalar.x > relativeScalar.y) 
+    ? relativeScalar.x : relativeScalar.y;
+  // NOTE: each pixel is assumed to be a centimeter in this simulation atm
+  for(size_t j = 0; j < rayPaths.get_segment_count(path); ++j)
+  { 
+    distance += rayPaths.get_segment_length(path, j) / scalar;
+  }
+
+  return distance / 34300.f * currentSamplingRate;
+}
+
+AudioBuffer Scene::build_path_impulse_response() const
+{
+  AudioBuffer response;
+  size_t bandCount = rayPaths.get_band_count();
+  if(rayPaths.empty() || bandCount == 0)
+  {
+    return response;
+  }
+
+  vector<unsigned> delays(rayPaths.size());
+  unsigned maxDelay = 0;
+  for(size_t i = 0; i < rayPaths.size(); ++i)
+  {
+    delays[i] = get_path_delay(i);
+    maxDelay = max(maxDelay, delays[i]);
+  }
+
+  // Matches the bands of the FilterBank used to render each path
+  Equalizer layout(bandCount, currentSamplingRate);
+  vector<BandPass> bands(bandCount);
+  size_t decayLength = 0;
+  for(size_t j = 0; j < bandCount; ++j)
+  {
+    bands[j] = BandPass(bandGrid.get_frequency(j), layout.get_quality()
+        , currentSamplingRate);
+    decayLength = max(decayLength, bands[j].get_decay_length());
+  }
+
+  // The response runs until the last path has rung out by 60 dB, so both
+  // buffers are allocated once at their final length
+  const size_t length = maxDelay + 1 + decayLength;
+  response.resize(length);
+  AudioBuffer impulses(length);
+  for(size_t j = 0; j < bandCount; ++j)
+  {
+    if(j > 0)
+    {
+      fill(impulses.data(), impulses.data() + length, 0.f);
+    }
+    for(size_t i = 0; i < rayPaths.size(); ++i)
     {
       // Divide the coefficent by the number of rays to ensure it doesn't get
       // overloaded
-      filters[i].add_coefficent(array.at(j).x, array.at(j).y / audioRays.size()
-          , static_cast<unsigned>(j));
+      impulses[delays[i]] += rayPaths.get_bands(i)[j]
+        / rayPaths.get_segment_count(i);
     }
 
-    ++i;
+    bands[j].apply_filter(impulses);
+    response += impulses;
+  }
+
+  static_cast<void>(Logger(Logger::L_MSG, "Built impulse response of "
+        + to_string(length) + " samples from " + to_string(rayPaths.size())
+        + " paths"));
+
+  return response;
+}
+
+void Scene::build_ray_vertices()
+{
+  rayVertices.clear();
+  rayVertices.reserve((rayPaths.get_point_total() - rayPaths.size()) * 2);
+
+  for(size_t i = 0; i < rayPaths.size(); ++i)
+  {
+    RayPaths::PATH_HIGHLIGHT highlight = rayPaths.get_highlight(i);
+    const Vec2 *points = rayPaths.get_points(i);
+    for(size_t j = 0; j < rayPaths.get_segment_count(i); ++j)
+    {
+      float level = rayPaths.get_segment_level(i, j);
+      sf::Color color;
+      if(highlight == RayPaths::PH_NONE)
+      {
+        float amp = map_range_to(level, 0.f, 1.f, 60.f, 160.f);
+        color = sf::Color(0.f, amp, 0.f, amp);
+      }
+      else
+      {
+        // The loudest and shortest paths are bolded
+        float amp = map_range_to(level, 0.f, 1.f, 130.f, 230.f);
+        switch(highlight)
+        {
+          case RayPaths::PH_LOUDEST:
+            color = sf::Color(amp, amp, 0.f, amp);
+            break;
+          case RayPaths::PH_SHORTEST:
+            color = sf::Color(0.f, amp, amp, amp);
+            break;
+          default:
+            color = sf::Color(amp, 0.f, amp, amp);
+            break;
+        }
+      }
+
+      sf::Vertex vertex;
+      vertex.color = color;
+      vertex.position = {points[j].x, points[j].y};
+      rayVertices.push_back(vertex);
+      vertex.position = {points[j + 1].x, points[j + 1].y};
+      rayVertices.push_back(vertex);
+    }
   }
 }
 
@@ -365,17 +591,19 @@ string Scene::get_name() const
 
 void Scene::clear()
 {
-  filters.clear();
+  filterBank.clear();
   currentSamplingRate = 0;
 
-  for(vector<AudioRay *> audioRays : audioRayVec) 
-    for(AudioRay *audioRay : audioRays) 
-      if (audioRay) delete audioRay;
-
-  audioRayVec.clear();
+  rayPaths.clear();
+  rayVertices.clear();
+  histogram.clear();
+  convolver.set_impulse_response(AudioBuffer());
 
   for(Object *object : objects) 
     if(object) delete object;
 
   objects.clear();
+
+  collisionGrid.clear();
+  edgeTable.clear();
 }
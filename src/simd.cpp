@@ -0,0 +1,76 @@
+/*!
+ *  \author Manoel McCadden
+ *  \date   10-17-26
+ *  \file   simd.cpp
+ *
+ *  \brief
+ *    Implementation of runtime detection of the SIMD instruction sets
+ */
+
+#include "simd.h"
+
+#include <atomic>
+
+#if ARMS_X86 && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+  SIMD_LEVEL detect_simd_level()
+  {
+#if ARMS_X86
+  #if defined(_MSC_VER)
+    int info[4] = {0, 0, 0, 0};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+
+    bool avx2 = false;
+    if(maxLeaf >= 7 && osxsave && avx)
+    {
+      // Make sure the OS saves the AVX registers
+      bool osAvx = (_xgetbv(0) & 0x6) == 0x6;
+      __cpuidex(info, 7, 0);
+      avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+    }
+  #else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+  #endif
+
+    if(avx2)
+    {
+      return SL_AVX2;
+    }
+    if(sse2)
+    {
+      return SL_SSE;
+    }
+#endif
+
+    return SL_SCALAR;
+  }
+
+  const SIMD_LEVEL supportedLevel = detect_simd_level();
+  atomic<int> levelLimit(SL_AVX2);
+}
+
+SIMD_LEVEL get_simd_level()
+{
+  int limit = levelLimit.load(memory_order_relaxed);
+  return (limit < supportedLevel) ? static_cast<SIMD_LEVEL>(limit)
+    : supportedLevel;
+}
+
+void limit_simd_level(const SIMD_LEVEL &level)
+{
+  levelLimit.store(level, memory_order_relaxed);
+}
@@ -10,12 +10,13 @@
 #include "source.h"
 
 Source::Source(const Vec2 &pos, const Vec2 &size, const float &_direction
-    , const float &_cone, const int &_checks, const int &_rays)
+    , const float &_cone, const int &_checks, const int &_rays
+    , const float &_threshold, const bool &_roulette)
   : Object(pos, size, "Source"), direction(_direction), cone(_cone)
-    , checks(_checks), rays(_rays)
+    , checks(_checks), rays(_rays), threshold(_threshold), roulette(_roulette)
 {
   set_color(sourceColor);
-  absortionCoefficents = CArray<Vec2>{{500.f, 0.f}};
+  absortionCoefficents = CoefficentArray{{500.f, 0.f}};
 }
 
 Source::~Source() { }
@@ -40,3 +41,13 @@ const int &Source::get_rays()
 {
   return rays;
 }
+
+const float &Source::get_threshold()
+{
+  return threshold;
+}
+
+const bool &Source::get_roulette()
+{
+  return roulette;
+}
@@ -12,10 +12,754 @@
 #include <cstring>
 #include <fstream>
 
+// Files are memory mapped on Linux and read into memory elsewhere
+#if defined(__linux__)
+  #define ARMS_MMAP 1
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#else
+  #define ARMS_MMAP 0
+#endif
+
 #include "helper.h"
+#include "simd.h"
 
 using namespace std;
 
+namespace
+{
+  // The layouts of pcm values that can be converted
+  enum PCM_FORMAT
+  {
+    PF_UINT8 = 0
+    , PF_INT16
+    , PF_INT24
+    , PF_INT32
+    , PF_FLOAT32
+    , PF_UNSUPPORTED
+  };
+
+  /*!
+   *  \returns
+   *    The layout of the pcm values of a header, extensible headers are
+   *    expected to already hold the format of their sub format
+   */
+  PCM_FORMAT get_pcm_format(const WAVE_HEADER &header)
+  {
+    if(header.audioFormat == WF_IEEE_FLOAT)
+    {
+      return (header.bitsPerSample == 32) ? PF_FLOAT32 : PF_UNSUPPORTED;
+    }
+    if(header.audioFormat != WF_PCM)
+    {
+      return PF_UNSUPPORTED;
+    }
+
+    switch(header.bitsPerSample)
+    {
+      case 8:
+        return PF_UINT8;
+      case 16:
+        return PF_INT16;
+      case 24:
+        return PF_INT24;
+      case 32:
+        return PF_INT32;
+      default:
+        return PF_UNSUPPORTED;
+    }
+  }
+
+  /*!
+   *  \returns
+   *    The number of bytes of each pcm value
+   */
+  size_t get_value_size(const WAVE_HEADER &header)
+  {
+    switch(get_pcm_format(header))
+    {
+      case PF_UINT8:
+        return 1;
+      case PF_INT24:
+        return 3;
+      case PF_INT32:
+      case PF_FLOAT32:
+        return 4;
+      default:
+        return 2;
+    }
+  }
+
+  // Integer values are scaled by powers of two when read so the conversion
+  // is exact, and by the largest value when written as the files always
+  // have been
+  const float UINT8_SCALE = 1.f / 128.f;
+  const float INT16_SCALE = 1.f / 32768.f;
+  // 24-bit values are read shifted into the top of an int32
+  const float INT32_SCALE = 1.f / 2147483648.f;
+  // The largest int32 can't be held by a float, so 32-bit values are scaled
+  // as doubles when written
+  const double INT32_MAX_SCALE = 2147483647.0;
+
+  /*!
+   *  Clamps a sample to [-1, 1], NaN becomes -1 the same as the SIMD kernels
+   */
+  float clamp_sample(const float &sample)
+  {
+    float clamped = (sample > -1.f) ? sample : -1.f;
+    return (clamped < 1.f) ? clamped : 1.f;
+  }
+
+  //===========//
+  // Scalar    //
+  //===========//
+
+  // Using memcpy instead of a reinterpret cast to avoid undefined behavior
+  void decode_uint8_scalar(const char *values, float *samples
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      uint8_t value = 0u;
+      memcpy(&value, values + i, sizeof(uint8_t));
+      samples[i] = (static_cast<float>(value) - 128.f) * UINT8_SCALE;
+    }
+  }
+
+  void decode_int16_scalar(const char *values, float *samples
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      int16_t value = 0;
+      memcpy(&value, values + 2 * i, sizeof(int16_t));
+      samples[i] = static_cast<float>(value) * INT16_SCALE;
+    }
+  }
+
+  void decode_int24_scalar(const char *values, float *samples
+      , const size_t &count)
+  {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(values);
+    for(size_t i = 0; i < count; ++i)
+    {
+      uint32_t value = (static_cast<uint32_t>(bytes[3 * i]) << 8)
+        | (static_cast<uint32_t>(bytes[3 * i + 1]) << 16)
+        | (static_cast<uint32_t>(bytes[3 * i + 2]) << 24);
+      samples[i] = static_cast<float>(static_cast<int32_t>(value))
+        * INT32_SCALE;
+    }
+  }
+
+  void decode_int32_scalar(const char *values, float *samples
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      int32_t value = 0;
+      memcpy(&value, values + 4 * i, sizeof(int32_t));
+      samples[i] = static_cast<float>(value) * INT32_SCALE;
+    }
+  }
+
+  void decode_float32(const char *values, float *samples, const size_t &count)
+  {
+    memcpy(samples, values, count * sizeof(float));
+  }
+
+  void encode_uint8_scalar(const float *samples, char *values
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      uint8_t value = static_cast<uint8_t>(clamp_sample(samples[i]) * 127.f
+          + 128.f);
+      memcpy(values + i, &value, sizeof(uint8_t));
+    }
+  }
+
+  void encode_int16_scalar(const float *samples, char *values
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      int16_t value = static_cast<int16_t>(clamp_sample(samples[i]) * 32767.f);
+      memcpy(values + 2 * i, &value, sizeof(int16_t));
+    }
+  }
+
+  void encode_int24_scalar(const float *samples, char *values
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      int32_t value = static_cast<int32_t>(clamp_sample(samples[i])
+          * 8388607.f);
+      // Little endian, the low three bytes of the value
+      values[3 * i] = static_cast<char>(value & 0xFF);
+      values[3 * i + 1] = static_cast<char>((value >> 8) & 0xFF);
+      values[3 * i + 2] = static_cast<char>((value >> 16) & 0xFF);
+    }
+  }
+
+  void encode_int32_scalar(const float *samples, char *values
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      int32_t value = static_cast<int32_t>(
+          static_cast<double>(clamp_sample(samples[i])) * INT32_MAX_SCALE);
+      memcpy(values + 4 * i, &value, sizeof(int32_t));
+    }
+  }
+
+  void encode_float32_scalar(const float *samples, char *values
+      , const size_t &count)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      float value = clamp_sample(samples[i]);
+      memcpy(values + 4 * i, &value, sizeof(float));
+    }
+  }
+
+#if ARMS_SSE2
+  //===========//
+  // SSE       //
+  //===========//
+
+  __m128 clamp_sse(const __m128 &samples)
+  {
+    // max returns its second operand for NaN
+    return _mm_min_ps(_mm_max_ps(samples, _mm_set1_ps(-1.f))
+        , _mm_set1_ps(1.f));
+  }
+
+  void decode_uint8_sse(const char *values, float *samples
+      , const size_t &count)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi32(128);
+    const __m128 scale = _mm_set1_ps(UINT8_SCALE);
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+      __m128i bytes = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(values + i));
+      __m128i words[2] = { _mm_unpacklo_epi8(bytes, zero)
+        , _mm_unpackhi_epi8(bytes, zero) };
+      for(size_t j = 0; j < 2; ++j)
+      {
+        __m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(words[j], zero), offset);
+        __m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(words[j], zero), offset);
+        _mm_storeu_ps(samples + i + 8 * j
+            , _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(samples + i + 8 * j + 4
+            , _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+      }
+    }
+
+    decode_uint8_scalar(values + i, samples + i, count - i);
+  }
+
+  void decode_int16_sse(const char *values, float *samples
+      , const size_t &count)
+  {
+    const __m128 scale = _mm_set1_ps(INT16_SCALE);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m128i words = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(values + 2 * i));
+      // Placing each value in the top half and shifting back sign extends it
+      __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+      __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+      _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+      _mm_storeu_ps(samples + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+
+    decode_int16_scalar(values + 2 * i, samples + i, count - i);
+  }
+
+  void decode_int32_sse(const char *values, float *samples
+      , const size_t &count)
+  {
+    const __m128 scale = _mm_set1_ps(INT32_SCALE);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+      __m128i words = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(values + 4 * i));
+      _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_cvtepi32_ps(words), scale));
+    }
+
+    decode_int32_scalar(values + 4 * i, samples + i, count - i);
+  }
+
+  void encode_uint8_sse(const float *samples, char *values
+      , const size_t &count)
+  {
+    const __m128 scale = _mm_set1_ps(127.f);
+    const __m128 offset = _mm_set1_ps(128.f);
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+      __m128i words[4];
+      for(size_t j = 0; j < 4; ++j)
+      {
+        __m128 scaled = _mm_add_ps(_mm_mul_ps(
+              clamp_sse(_mm_loadu_ps(samples + i + 4 * j)), scale), offset);
+        words[j] = _mm_cvttps_epi32(scaled);
+      }
+      __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(words[0], words[1])
+          , _mm_packs_epi32(words[2], words[3]));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), bytes);
+    }
+
+    encode_uint8_scalar(samples + i, values + i, count - i);
+  }
+
+  void encode_int16_sse(const float *samples, char *values
+      , const size_t &count)
+  {
+    const __m128 scale = _mm_set1_ps(32767.f);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(
+            clamp_sse(_mm_loadu_ps(samples + i)), scale));
+      __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(
+            clamp_sse(_mm_loadu_ps(samples + i + 4)), scale));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(values + 2 * i)
+          , _mm_packs_epi32(lo, hi));
+    }
+
+    encode_int16_scalar(samples + i, values + 2 * i, count - i);
+  }
+
+  void encode_int32_sse(const float *samples, char *values
+      , const size_t &count)
+  {
+    const __m128d scale = _mm_set1_pd(INT32_MAX_SCALE);
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+      // Each half of the samples is widened to doubles and scaled, then
+      // the two pairs of words are joined
+      __m128 clamped = clamp_sse(_mm_loadu_ps(samples + i));
+      __m128i low = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(clamped), scale));
+      __m128i high = _mm_cvttpd_epi32(_mm_mul_pd(
+            _mm_cvtps_pd(_mm_movehl_ps(clamped, clamped)), scale));
+      __m128i words = _mm_unpacklo_epi64(low, high);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(values + 4 * i), words);
+    }
+
+    encode_int32_scalar(samples + i, values + 4 * i, count - i);
+  }
+
+  void encode_float32_sse(const float *samples, char *values
+      , const size_t &count)
+  {
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+      _mm_storeu_ps(reinterpret_cast<float *>(values + 4 * i)
+          , clamp_sse(_mm_loadu_ps(samples + i)));
+    }
+
+    encode_float32_scalar(samples + i, values + 4 * i, count - i);
+  }
+#endif
+
+#if ARMS_X86
+  //===========//
+  // AVX2      //
+  //===========//
+
+  ARMS_TARGET_AVX2
+  __m256 clamp_avx2(const __m256 &samples)
+  {
+    // max returns its second operand for NaN
+    return _mm256_min_ps(_mm256_max_ps(samples, _mm256_set1_ps(-1.f))
+        , _mm256_set1_ps(1.f));
+  }
+
+  ARMS_TARGET_AVX2
+  void decode_uint8_avx2(const char *values, float *samples
+      , const size_t &count)
+  {
+    const __m256i offset = _mm256_set1_epi32(128);
+    const __m256 scale = _mm256_set1_ps(UINT8_SCALE);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m256i words = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(
+              reinterpret_cast<const __m128i *>(values + i))), offset);
+      _mm256_storeu_ps(samples + i
+          , _mm256_mul_ps(_mm256_cvtepi32_ps(words), scale));
+    }
+
+    decode_uint8_scalar(values + i, samples + i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void decode_int16_avx2(const char *values, float *samples
+      , const size_t &count)
+  {
+    const __m256 scale = _mm256_set1_ps(INT16_SCALE);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m256i words = _mm256_cvtepi16_epi32(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(values + 2 * i)));
+      _mm256_storeu_ps(samples + i
+          , _mm256_mul_ps(_mm256_cvtepi32_ps(words), scale));
+    }
+
+    decode_int16_scalar(values + 2 * i, samples + i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void decode_int24_avx2(const char *values, float *samples
+      , const size_t &count)
+  {
+    // Moves each group of three bytes into the top of an int32
+    const __m256i spread = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+        , -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 scale = _mm256_set1_ps(INT32_SCALE);
+    size_t i = 0;
+    // Each half loads 16 bytes for 12, so stop early enough to stay in the
+    // values
+    for(; i + 10 <= count; i += 8)
+    {
+      const char *bytes = values + 3 * i;
+      __m256i words = _mm256_setr_m128i(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes))
+          , _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + 12)));
+      words = _mm256_shuffle_epi8(words, spread);
+      _mm256_storeu_ps(samples + i
+          , _mm256_mul_ps(_mm256_cvtepi32_ps(words), scale));
+    }
+
+    decode_int24_scalar(values + 3 * i, samples + i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void decode_int32_avx2(const char *values, float *samples
+      , const size_t &count)
+  {
+    const __m256 scale = _mm256_set1_ps(INT32_SCALE);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m256i words = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(values + 4 * i));
+      _mm256_storeu_ps(samples + i
+          , _mm256_mul_ps(_mm256_cvtepi32_ps(words), scale));
+    }
+
+    decode_int32_scalar(values + 4 * i, samples + i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void encode_uint8_avx2(const float *samples, char *values
+      , const size_t &count)
+  {
+    const __m256 scale = _mm256_set1_ps(127.f);
+    const __m256 offset = _mm256_set1_ps(128.f);
+    // Packing works within each 128-bit half, this puts the groups of four
+    // back in order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    size_t i = 0;
+    for(; i + 32 <= count; i += 32)
+    {
+      __m256i words[4];
+      for(size_t j = 0; j < 4; ++j)
+      {
+        __m256 scaled = _mm256_add_ps(_mm256_mul_ps(
+              clamp_avx2(_mm256_loadu_ps(samples + i + 8 * j)), scale)
+            , offset);
+        words[j] = _mm256_cvttps_epi32(scaled);
+      }
+      __m256i bytes = _mm256_packus_epi16(
+          _mm256_packs_epi32(words[0], words[1])
+          , _mm256_packs_epi32(words[2], words[3]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i)
+          , _mm256_permutevar8x32_epi32(bytes, order));
+    }
+
+    encode_uint8_scalar(samples + i, values + i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void encode_int16_avx2(const float *samples, char *values
+      , const size_t &count)
+  {
+    const __m256 scale = _mm256_set1_ps(32767.f);
+    size_t i = 0;
+    for(; i + 16 <= count; i += 16)
+    {
+      __m256i lo = _mm256_cvttps_epi32(_mm256_mul_ps(
+            clamp_avx2(_mm256_loadu_ps(samples + i)), scale));
+      __m256i hi = _mm256_cvttps_epi32(_mm256_mul_ps(
+            clamp_avx2(_mm256_loadu_ps(samples + i + 8)), scale));
+      // Packing works within each 128-bit half so the halves are swapped
+      // back in order
+      __m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi)
+          , _MM_SHUFFLE(3, 1, 2, 0));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + 2 * i), words);
+    }
+
+    encode_int16_scalar(samples + i, values + 2 * i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void encode_int24_avx2(const float *samples, char *values
+      , const size_t &count)
+  {
+    // Packs the low three bytes of each int32 into the front of each half
+    const __m256i pack = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+        , 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m256 scale = _mm256_set1_ps(8388607.f);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      __m256i words = _mm256_shuffle_epi8(_mm256_cvttps_epi32(_mm256_mul_ps(
+              clamp_avx2(_mm256_loadu_ps(samples + i)), scale)), pack);
+      __m128i halves[2] = { _mm256_castsi256_si128(words)
+        , _mm256_extracti128_si256(words, 1) };
+      for(size_t j = 0; j < 2; ++j)
+      {
+        char *bytes = values + 3 * i + 12 * j;
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(bytes), halves[j]);
+        int32_t last = _mm_cvtsi128_si32(_mm_srli_si128(halves[j], 8));
+        memcpy(bytes + 8, &last, sizeof(int32_t));
+      }
+    }
+
+    encode_int24_scalar(samples + i, values + 3 * i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void encode_int32_avx2(const float *samples, char *values
+      , const size_t &count)
+  {
+    const __m256d scale = _mm256_set1_pd(INT32_MAX_SCALE);
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      // Each half of the samples is widened to doubles and scaled
+      __m256 clamped = clamp_avx2(_mm256_loadu_ps(samples + i));
+      __m128i low = _mm256_cvttpd_epi32(_mm256_mul_pd(
+            _mm256_cvtps_pd(_mm256_castps256_ps128(clamped)), scale));
+      __m128i high = _mm256_cvttpd_epi32(_mm256_mul_pd(
+            _mm256_cvtps_pd(_mm256_extractf128_ps(clamped, 1)), scale));
+      __m256i words = _mm256_insertf128_si256(_mm256_castsi128_si256(low)
+          , high, 1);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + 4 * i), words);
+    }
+
+    encode_int32_scalar(samples + i, values + 4 * i, count - i);
+  }
+
+  ARMS_TARGET_AVX2
+  void encode_float32_avx2(const float *samples, char *values
+      , const size_t &count)
+  {
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+      _mm256_storeu_ps(reinterpret_cast<float *>(values + 4 * i)
+          , clamp_avx2(_mm256_loadu_ps(samples + i)));
+    }
+
+    encode_float32_scalar(samples + i, values + 4 * i, count - i);
+  }
+#endif
+
+  using DECODE_KERNEL = void (*)(const char *, float *, const size_t &);
+  using ENCODE_KERNEL = void (*)(const float *, char *, const size_t &);
+
+  struct PCM_KERNELS
+  {
+    DECODE_KERNEL decode;
+    ENCODE_KERNEL encode;
+  };
+
+  /*!
+   *  \returns
+   *    The kernels converting a supported format at the current SIMD level
+   */
+  PCM_KERNELS get_pcm_kernels(const PCM_FORMAT &format)
+  {
+    // Indexed by PCM_FORMAT, floats are copied as fast as memcpy allows
+    static const PCM_KERNELS scalarKernels[] =
+    {
+      { decode_uint8_scalar, encode_uint8_scalar }
+      , { decode_int16_scalar, encode_int16_scalar }
+      , { decode_int24_scalar, encode_int24_scalar }
+      , { decode_int32_scalar, encode_int32_scalar }
+      , { decode_float32, encode_float32_scalar }
+    };
+#if ARMS_SSE2
+    // Moving 24-bit values around needs byte shuffles SSE2 doesn't have
+    static const PCM_KERNELS sseKernels[] =
+    {
+      { decode_uint8_sse, encode_uint8_sse }
+      , { decode_int16_sse, encode_int16_sse }
+      , { decode_int24_scalar, encode_int24_scalar }
+      , { decode_int32_sse, encode_int32_sse }
+      , { decode_float32, encode_float32_sse }
+    };
+#endif
+#if ARMS_X86
+    static const PCM_KERNELS avx2Kernels[] =
+    {
+      { decode_uint8_avx2, encode_uint8_avx2 }
+      , { decode_int16_avx2, encode_int16_avx2 }
+      , { decode_int24_avx2, encode_int24_avx2 }
+      , { decode_int32_avx2, encode_int32_avx2 }
+      , { decode_float32, encode_float32_avx2 }
+    };
+#endif
+
+    switch(get_simd_level())
+    {
+#if ARMS_X86
+      case SL_AVX2:
+        return avx2Kernels[format];
+#endif
+#if ARMS_SSE2
+      case SL_SSE:
+        return sseKernels[format];
+#endif
+      default:
+        return scalarKernels[format];
+    }
+  }
+
+  /*!
+   *  Converts pcm values into float samples
+   *
+   *  \param values
+   *    count pcm values in the format of the header
+   *  \param samples
+   *    count samples
+   */
+  void convert_pcm_to_float(const char *values, float *samples
+      , const size_t &count, const WAVE_HEADER &header)
+  {
+    PCM_FORMAT format = get_pcm_format(header);
+    if(format == PF_UNSUPPORTED)
+    {
+      memset(samples, 0, count * sizeof(float));
+      return;
+    }
+
+    get_pcm_kernels(format).decode(values, samples, count);
+  }
+
+  /*!
+   *  Converts float samples into pcm values, clamping samples outside of
+   *  [-1, 1] rather than letting them wrap around
+   *
+   *  \param samples
+   *    count samples
+   *  \param values
+   *    count pcm values in the format of the header
+   */
+  void convert_float_to_pcm(const float *samples, char *values
+      , const size_t &count, const WAVE_HEADER &header)
+  {
+    PCM_FORMAT format = get_pcm_format(header);
+    if(format == PF_UNSUPPORTED)
+    {
+      format = PF_INT16;
+    }
+
+    get_pcm_kernels(format).encode(samples, values, count);
+  }
+
+  /*!
+   *  Validates the chunks of a .wav file held in memory, reading its format
+   *  and finding its pcm values without copying them. Unknown chunks are
+   *  skipped and a truncated data chunk keeps the values it has.
+   *
+   *  \param data
+   *    The whole file
+   *  \param size
+   *    The size of the file in bytes
+   *  \param header
+   *    The header the format is read into
+   *  \param valuesOffset
+   *    The offset of the pcm values within the file
+   *
+   *  \returns
+   *    If the file is a valid .wav file
+   */
+  bool parse_wave_chunks(const char *data, const size_t &size
+      , WAVE_HEADER &header, size_t &valuesOffset)
+  {
+    if(size < 12 || strncmp(data, "RIFF", 4) != 0
+        || strncmp(data + 8, "WAVE", 4) != 0)
+    {
+      return false;
+    }
+    memcpy(&header.riffSize, data + 4, sizeof(uint32_t));
+
+    bool foundFormat = false;
+    size_t offset = 12;
+    while(offset + 8 <= size)
+    {
+      const char *chunk = data + offset + 8;
+      const size_t available = size - offset - 8;
+      uint32_t chunkSize = 0u;
+      memcpy(&chunkSize, data + offset + 4, sizeof(uint32_t));
+
+      if(strncmp(data + offset, "fmt ", 4) == 0)
+      {
+        if(chunkSize < 16 || chunkSize > available)
+        {
+          return false;
+        }
+        header.fmtSize = chunkSize;
+        memcpy(&header.audioFormat, chunk, sizeof(uint16_t));
+        memcpy(&header.channelCount, chunk + 2, sizeof(uint16_t));
+        memcpy(&header.samplingRate, chunk + 4, sizeof(uint32_t));
+        memcpy(&header.bytesPerSecond, chunk + 8, sizeof(uint32_t));
+        memcpy(&header.bytesPerSample, chunk + 12, sizeof(uint16_t));
+        memcpy(&header.bitsPerSample, chunk + 14, sizeof(uint16_t));
+        // The sub format starts with the format it extends
+        if(header.audioFormat == WF_EXTENSIBLE && chunkSize >= 40)
+        {
+          memcpy(&header.audioFormat, chunk + 24, sizeof(uint16_t));
+        }
+        foundFormat = true;
+      }
+      else if(strncmp(data + offset, "data", 4) == 0)
+      {
+        if(!foundFormat)
+        {
+          return false;
+        }
+        header.dataSize = static_cast<uint32_t>(
+            min(static_cast<size_t>(chunkSize), available));
+        valuesOffset = offset + 8;
+        return true;
+      }
+
+      // Chunks are padded to an even number of bytes
+      offset += 8 + static_cast<size_t>(chunkSize) + (chunkSize & 1u);
+    }
+
+    return false;
+  }
+}
+
 //==============================================================================
 //  Wave Header 
 //==============================================================================
@@ -98,7 +842,7 @@ char *WAVE_HEADER::generate_wave_header()
 
 void WAVE_HEADER::read_wave_header(std::fstream &file)
 {
-  file.read(headerData, 44);
+  file.read(headerData, 36);
 
   // Using strncmp as the char arrays arn't 0 terminated so they will read the
   // next value in struct causing errors
@@ -122,14 +866,26 @@ void WAVE_HEADER::read_wave_header(std::fstream &file)
   memcpy(&bytesPerSample, headerData + 32, sizeof(uint16_t));
   memcpy(&bitsPerSample, headerData + 34, sizeof(uint16_t));
 
+  // Anything past the basic format, i.e. the sub format of an extensible file
+  if(fmtSize > 16)
+  {
+    vector<char> extension(fmtSize - 16 + (fmtSize & 1u));
+    file.read(extension.data(), extension.size());
+    if(audioFormat == WF_EXTENSIBLE && fmtSize >= 40 && file)
+    {
+      memcpy(&audioFormat, extension.data() + 8, sizeof(uint16_t));
+    }
+  }
+  file.read(headerData + 36, 8);
+
   // Skip any non-data blocks
   while(!file.eof() && strncmp(headerData + 36, "data", 4) != 0)
   {
-    uint32_t size = static_cast<uint32_t>(*(headerData + 40)); 
-    char *skipper = new char[size];
-    file.read(skipper, size);
+    uint32_t size = 0u;
+    memcpy(&size, headerData + 40, sizeof(uint32_t));
+    // Chunks are padded to an even number of bytes
+    file.ignore(static_cast<streamsize>(size) + (size & 1u));
     file.read(headerData + 36, 8);
-    delete []skipper;
   }
 
 
@@ -138,148 +894,62 @@ void WAVE_HEADER::read_wave_header(std::fstream &file)
 }
 
 //==============================================================================
-//  Samples
+//  WaveFile 
 //==============================================================================
 
-SAMPLES::SAMPLES() : frameCount(0), sampleArray(nullptr) { }
-
-SAMPLES::SAMPLES(const SAMPLES &samples)
-  : frameCount(0), sampleArray(nullptr)
-{
-  *this = samples;
-}
-
-SAMPLES::~SAMPLES()
-{
-  clear();
-}
+WaveFile::WaveFile() { }
 
-SAMPLES &SAMPLES::operator=(const SAMPLES &samples)
+WaveFile::WaveFile(const string &fileName)
 {
-  clear();
-
-  if(samples.frameCount == 0)
-  {
-    return *this;
-  }
-
-  resize(samples.frameCount);
-
-  memcpy(sampleArray, samples.sampleArray, frameCount * sizeof(float));
-
-  return *this;
+  open_file(fileName);
 }
 
-void SAMPLES::resize()
+WaveFile::WaveFile(const WaveFile &wave)
+  : open(wave.open), name(wave.name), header(wave.header), samples(wave.samples)
 {
-  resize(2 * frameCount);
+  
 }
 
-void SAMPLES::resize(const size_t &size)
+WaveFile::WaveFile(WaveFile &&wave) noexcept
+  : open(wave.open), name(move(wave.name)), header(wave.header)
+  , samples(move(wave.samples))
 {
-  if(size == 0)
-  {
-    clear();
-    return;
-  }
-
-  static_cast<void>(Logger(Logger::L_MSG
-        , "Resizing SAMPLES to size: " + to_string(size)));
-
-  float *newArray = new float[size];
-
-  // In order to not copy into outside of the bounds of the new
-  // array we will set the frameCount to the lower option between
-  // it and size and "truncate" all values after
-  if(frameCount > size)
-  {
-    frameCount = size;
-  }
-
-  if(frameCount > 0)
-  {
-    memcpy(newArray, sampleArray, frameCount * sizeof(float));
-  }
-  // Set all newly allocated index's to 0, if size is greater than frameCount
-  if(size > frameCount)
-  {
-    memset(newArray + frameCount, 0, sizeof(float) * (size - frameCount));
-  }
-
-  clear();
-
-  frameCount = size;
-  sampleArray = newArray;
+  wave.open = false;
 }
 
-float &SAMPLES::operator[](const size_t &index)
-{
-  if(index > frameCount)
-  {
-    // NOTE: A warning that a reallocation is occuring should be added here
-    static_cast<void>(Logger(Logger::L_WRN
-          , string("Attempted to dereference invalid index, ")
-            + "reallocating sample array to size of: " + to_string(index)));
-    resize(index);
-  }
-
-  return sampleArray[index];
-}
+WaveFile::~WaveFile() { }
 
-const float &SAMPLES::at(const size_t &index) const
+WaveFile &WaveFile::operator=(const WaveFile &wave)
 {
-  if(index > frameCount)
+  if(this == &wave)
   {
-    // NOTE: An error log should be added here
-    static_cast<void>(Logger(Logger::L_ERR
-          , string("Attempted to dereference invalid index, ")
-            + "return last index of sample array instead"));
-    return sampleArray[frameCount - 1];
+    return *this;
   }
 
-  return sampleArray[index];
-}
-
-const float *SAMPLES::front() const
-{
-  return sampleArray;
-}
+  open = wave.open;
+  name = wave.name;
+  header = wave.header;
+  samples = wave.samples;
 
-const size_t SAMPLES::size() const
-{
-  return frameCount;
+  return *this;
 }
 
-void SAMPLES::clear()
+WaveFile &WaveFile::operator=(WaveFile &&wave) noexcept
 {
-  if(sampleArray)
+  if(this == &wave)
   {
-    delete []sampleArray;
-    sampleArray = nullptr;
+    return *this;
   }
 
-  frameCount = 0;
-}
-
-//==============================================================================
-//  WaveFile 
-//==============================================================================
-
-WaveFile::WaveFile() { }
-
-WaveFile::WaveFile(const string &fileName)
-{
-  open_file(fileName);
-}
+  open = wave.open;
+  name = move(wave.name);
+  header = wave.header;
+  samples = move(wave.samples);
+  wave.open = false;
 
-WaveFile::WaveFile(const WaveFile &wave)
-  : open(wave.open), name(wave.name), header(wave.header), samples(wave.samples)
-{
-  
+  return *this;
 }
 
-WaveFile::~WaveFile() { }
-
 bool WaveFile::is_open() const
 {
   return open;
@@ -320,7 +990,32 @@ void WaveFile::open_file(const string &fileName, const bool &ignoreInputDir)
     return;
   }
 
+  // The samples are converted straight from the mapped file rather than
+  // read into a buffer first
+  if(WaveMap::is_mapping_supported())
+  {
+    file.close();
+
+    WaveMap map;
+    if(!map.open(ignoreInputDir ? fileName : INPUT_DIR + fileName + ".wav"))
+    {
+      return;
+    }
+
+    header = map.get_header();
+    header.generate_wave_header();
+    convert_from_pcm_values(map.get_values());
+    open = true;
+    return;
+  }
+
   header.read_wave_header(file);
+  if(get_pcm_format(header) == PF_UNSUPPORTED)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Unsupported Wav format passed in for reading" ));
+    return;
+  }
 
   char *values = new char[header.dataSize];
   file.read(values, header.dataSize);
@@ -351,6 +1046,9 @@ void WaveFile::output_to_file(const string &fileName)
   }
 
   char *pcmValues = convert_to_pcm_values();
+  // Only the basic format is written, extensible files were read as the
+  // format they extend
+  header.fmtSize = 16;
   header.generate_wave_header();
 
   file.write(header.headerData, 44);
@@ -369,73 +1067,384 @@ unsigned WaveFile::get_sampling_rate() const
   return header.samplingRate;
 }
 
-CArray<float> &WaveFile::get_samples()
+AudioBuffer &WaveFile::get_samples()
 {
   return samples;
 }
 
-void WaveFile::convert_from_pcm_values(char *values)
+void WaveFile::convert_from_pcm_values(const char *values)
 {
-  char *data = values;
-  size_t frameCount = header.dataSize / header.channelCount / header.bytesPerSample;
-  samples.resize(frameCount);
-
-  if(header.bitsPerSample == 8)
+  // Every value is a sample, interleaved if there are several channels
+  size_t frameCount = header.dataSize / get_value_size(header);
+  // Every sample is written by the conversion so none are zeroed first
+  samples.resize_uninitialized(frameCount);
+  if(frameCount == 0)
   {
-    for(size_t i = 0; i < frameCount; ++i)
-    {
-      uint8_t sample = 0u;
-      // Using memcpy instead of a reinterpret cast to avoid undefined behavior
-      // NOTE: This isn't a worry with an 8-bit size but we are doing it for
-      // consistency
-      memcpy(&sample, data, sizeof(uint8_t));
-      samples[i] = (static_cast<float>(sample) - 128.f) / 128.f;
-      data += sizeof(uint8_t);
-    }
-  }
-  else
-  {
-    for(size_t i = 0; i < frameCount; ++i)
-    {
-      int16_t sample = 0;
-      // Using memcpy instead of a reinterpret cast to avoid undefined behavior
-      memcpy(&sample, data, sizeof(int16_t));
-      samples[i] = static_cast<float>(sample) / 32768.f;
-      data += sizeof(int16_t);
-    }
+    return;
   }
+
+  convert_pcm_to_float(values, samples.data(), frameCount, header);
 }
 
 char *WaveFile::convert_to_pcm_values()
 {
   size_t frameCount = samples.size();
-  header.dataSize = frameCount * header.channelCount * header.bytesPerSample;
+  header.dataSize = frameCount * get_value_size(header);
   header.riffSize = 36 + header.dataSize;
   char *values = new char[header.dataSize];
-  char *data = values;
 
-  if(header.bitsPerSample == 8)
+  convert_float_to_pcm(samples.front(), values, frameCount, header);
+  
+  return values;
+}
+
+//==============================================================================
+//  Wave Map
+//==============================================================================
+
+WaveMap::WaveMap() { }
+
+WaveMap::~WaveMap()
+{
+  close();
+}
+
+bool WaveMap::is_mapping_supported()
+{
+  return ARMS_MMAP;
+}
+
+bool WaveMap::open(const string &path)
+{
+  close();
+
+  const char *data = nullptr;
+  size_t size = 0;
+#if ARMS_MMAP
+  int descriptor = ::open(path.c_str(), O_RDONLY);
+  if(descriptor < 0)
   {
-    for(size_t i = 0; i < frameCount; ++i)
-    {
-      uint8_t sample = static_cast<uint8_t>(samples[i] * 127.f + 128.f);
-      // Using memcpy instead of a reinterpret cast to avoid undefined behavior
-      // NOTE: This isn't a worry with an 8-bit size but we are doing it for
-      // consistency
-      memcpy(data, &sample, sizeof(uint8_t));
-      data += sizeof(uint8_t);
-    }
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Failed to access given Wav file" ));
+    return false;
   }
-  else
+
+  struct stat status;
+  if(fstat(descriptor, &status) == 0 && status.st_size > 0)
+  {
+    mappingSize = static_cast<size_t>(status.st_size);
+    mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, descriptor, 0);
+  }
+  // The mapping keeps the file open on its own
+  ::close(descriptor);
+
+  if(!mapping || mapping == MAP_FAILED)
+  {
+    mapping = nullptr;
+    mappingSize = 0;
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Failed to map given Wav file" ));
+    return false;
+  }
+  // Renders read the file front to back
+  madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+  data = static_cast<const char *>(mapping);
+  size = mappingSize;
+#else
+  ifstream file(path, ios::in | ios::binary);
+  if(!file)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Failed to access given Wav file" ));
+    return false;
+  }
+
+  fileData.assign(istreambuf_iterator<char>(file)
+      , istreambuf_iterator<char>());
+  data = fileData.data();
+  size = fileData.size();
+#endif
+
+  size_t valuesOffset = 0;
+  header = WAVE_HEADER();
+  if(!parse_wave_chunks(data, size, header, valuesOffset)
+      || header.channelCount == 0)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Invalid wave file passed in for reading" ));
+    close();
+    return false;
+  }
+  if(get_pcm_format(header) == PF_UNSUPPORTED)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Unsupported Wav format passed in for reading" ));
+    close();
+    return false;
+  }
+
+  values = data + valuesOffset;
+  sampleCount = header.dataSize / get_value_size(header);
+
+  return true;
+}
+
+void WaveMap::close()
+{
+#if ARMS_MMAP
+  if(mapping)
+  {
+    munmap(mapping, mappingSize);
+  }
+#endif
+  mapping = nullptr;
+  mappingSize = 0;
+  fileData.clear();
+  fileData.shrink_to_fit();
+  values = nullptr;
+  sampleCount = 0;
+}
+
+bool WaveMap::is_open() const
+{
+  return values != nullptr;
+}
+
+const WAVE_HEADER &WaveMap::get_header() const
+{
+  return header;
+}
+
+unsigned WaveMap::get_sampling_rate() const
+{
+  return header.samplingRate;
+}
+
+size_t WaveMap::get_sample_count() const
+{
+  return sampleCount;
+}
+
+const char *WaveMap::get_values() const
+{
+  return values;
+}
+
+size_t WaveMap::read_samples(float *output, const size_t &first
+    , const size_t &count) const
+{
+  if(!values || first >= sampleCount)
+  {
+    return 0;
+  }
+
+  const size_t valueSize = get_value_size(header);
+  size_t read = min(count, sampleCount - first);
+  convert_pcm_to_float(values + first * valueSize, output, read, header);
+
+  return read;
+}
+
+//==============================================================================
+//  Wave Reader
+//==============================================================================
+
+WaveReader::WaveReader() { }
+
+WaveReader::~WaveReader()
+{
+  close();
+}
+
+bool WaveReader::open(const string &fileName, const bool &ignoreInputDir)
+{
+  close();
+
+  string path = ignoreInputDir ? fileName : INPUT_DIR + fileName + ".wav";
+  samplesRead = 0;
+  if(WaveMap::is_mapping_supported())
   {
-    for(size_t i = 0; i < frameCount; ++i)
+    if(!map.open(path))
     {
-      int16_t sample = static_cast<int16_t>(samples[i] * 32767.f);
-      // Using memcpy instead of a reinterpret cast to avoid undefined behavior
-      memcpy(data, &sample, sizeof(int16_t));
-      data += sizeof(int16_t);
+      return false;
     }
+    header = map.get_header();
+    sampleCount = map.get_sample_count();
+    return true;
   }
-  
-  return values;
+
+  file.open(path, ios::in | ios::binary);
+  if(!file)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Failed to access given Wav file" ));
+    return false;
+  }
+
+  header = WAVE_HEADER();
+  header.read_wave_header(file);
+  if(!file)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Failed to read the header of the given Wav file" ));
+    close();
+    return false;
+  }
+  if(get_pcm_format(header) == PF_UNSUPPORTED)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Unsupported Wav format passed in for reading" ));
+    close();
+    return false;
+  }
+
+  sampleCount = header.dataSize / get_value_size(header);
+  samplesRead = 0;
+
+  return true;
+}
+
+void WaveReader::close()
+{
+  map.close();
+  if(file.is_open())
+  {
+    file.close();
+  }
+  sampleCount = 0;
+  samplesRead = 0;
+}
+
+bool WaveReader::is_open() const
+{
+  return map.is_open() || file.is_open();
+}
+
+const WAVE_HEADER &WaveReader::get_header() const
+{
+  return header;
+}
+
+unsigned WaveReader::get_sampling_rate() const
+{
+  return header.samplingRate;
+}
+
+size_t WaveReader::get_sample_count() const
+{
+  return sampleCount;
+}
+
+size_t WaveReader::read_block(float *output, const size_t &count)
+{
+  if(map.is_open())
+  {
+    size_t read = map.read_samples(output, samplesRead, count);
+    samplesRead += read;
+    return read;
+  }
+  if(!file.is_open())
+  {
+    return 0;
+  }
+
+  const size_t valueSize = get_value_size(header);
+  size_t wanted = min(count, sampleCount - samplesRead);
+  pcmValues.resize(wanted * valueSize);
+  file.read(pcmValues.data(), pcmValues.size());
+
+  // A truncated file ends early rather than reading garbage
+  size_t read = static_cast<size_t>(file.gcount()) / valueSize;
+  convert_pcm_to_float(pcmValues.data(), output, read, header);
+  samplesRead += read;
+  if(read < wanted)
+  {
+    sampleCount = samplesRead;
+  }
+
+  return read;
+}
+
+//==============================================================================
+//  Wave Writer
+//==============================================================================
+
+WaveWriter::WaveWriter() { }
+
+WaveWriter::~WaveWriter()
+{
+  close();
+}
+
+bool WaveWriter::open(const string &fileName, const WAVE_HEADER &format)
+{
+  close();
+
+  file.open(fileName + ".wav", ios::out | ios::binary | ios::trunc);
+  if(!file)
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Failed to create given Wav file" ));
+    return false;
+  }
+
+  // Files are written in the format of the input, or 16-bit if it can't be
+  header = WAVE_HEADER();
+  header.set_channelCount(format.channelCount);
+  header.set_samplingRate(format.samplingRate);
+  if(get_pcm_format(format) != PF_UNSUPPORTED)
+  {
+    header.audioFormat = format.audioFormat;
+    header.set_bitsPerSample(format.bitsPerSample);
+  }
+  // The block align covers every channel of a frame
+  header.bytesPerSample = header.channelCount * get_value_size(header);
+  header.bytesPerSecond = header.bytesPerSample * header.samplingRate;
+  header.dataSize = 0;
+  header.riffSize = 36;
+  samplesWritten = 0;
+
+  // The sizes are patched once every block is written
+  file.write(header.generate_wave_header(), 44);
+
+  return true;
+}
+
+void WaveWriter::close()
+{
+  if(!file.is_open())
+  {
+    return;
+  }
+
+  header.dataSize = samplesWritten * get_value_size(header);
+  header.riffSize = 36 + header.dataSize;
+  header.generate_wave_header();
+
+  file.seekp(4);
+  file.write(header.headerData + 4, sizeof(uint32_t));
+  file.seekp(40);
+  file.write(header.headerData + 40, sizeof(uint32_t));
+  file.close();
+}
+
+bool WaveWriter::is_open() const
+{
+  return file.is_open();
+}
+
+void WaveWriter::write_block(const float *input, const size_t &count)
+{
+  if(!file.is_open())
+  {
+    static_cast<void>(Logger(Logger::L_ERR
+          , "Cannot write to a Wav file that isn't open" ));
+    return;
+  }
+
+  pcmValues.resize(count * get_value_size(header));
+  convert_float_to_pcm(input, pcmValues.data(), count, header);
+  file.write(pcmValues.data(), pcmValues.size());
+  samplesWritten += count;
 }